@@ -0,0 +1,306 @@
+/**
+ * Benchmarks for the planning core, runnable without a ROS master: trajectory rollouts, each map cost type, and
+ * each optimizer, on a synthetic map and on any recorded maps given on the command line.
+ *
+ * Usage: planning_benchmark [--benchmark_* flags] [--map_resolution=0.05] [map.png ...]
+ *
+ * A recorded map is a grayscale image of an occupancy grid (cell value = pixel value, 0 to 100, anything above
+ * is unknown), with the robot at the center of the image facing +x (right). Save one from a bag with e.g.
+ * `rosrun map_server map_saver -f map map:=/local_mapper/costmap/costmap` and convert to raw occupancy values.
+ */
+
+#include <benchmark/benchmark.h>
+#include <rr_common/planning/annealing_optimizer.h>
+#include <rr_common/planning/bicycle_model.h>
+#include <rr_common/planning/distance_map.h>
+#include <rr_common/planning/hill_climb_optimizer.h>
+#include <rr_common/planning/inflation_map.h>
+#include <rr_common/planning/nearest_point_cache.h>
+#include <rr_common/planning/planning_utils.h>
+#include <rr_common/planning/trajectory_cost.h>
+
+#include <atomic>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int ctrl_dim = 1;
+
+// parameters follow rr_evgp/conf/planner_sim.yaml
+const rr::LinearTrackingFilter::Params steer_filter_params{ 0, -0.25, 0.25, -2.0, 2.0 };
+const rr::LinearTrackingFilter::Params speed_filter_params{ 0, -1.0, 13.5, -25.0, 20.0 };
+const rr::BicycleModel::Params bicycle_params{ 0.97, 7.0, 25, 0.02 };
+const rr::Rectangle hitbox(-0.2, 1.6, -0.7, 0.7);
+const rr::CostWeights cost_weights{ 0.1, 0.05, 0.01, 0, 10000 };
+const int n_segments = 7;
+
+struct BenchmarkMap {
+    std::string name;
+    rr::OccupancyGrid grid;
+    rr::Pose robot_pose;  // robot pose in the grid frame
+    pcl::PointCloud<pcl::PointXYZ> obstacles;  // occupied cells in the robot frame
+};
+
+std::vector<BenchmarkMap> g_maps;
+
+void FillObstacles(BenchmarkMap& map) {
+    map.obstacles.clear();
+    const double cos_th = std::cos(map.robot_pose.theta);
+    const double sin_th = std::sin(map.robot_pose.theta);
+    for (unsigned int my = 0; my < map.grid.height; ++my) {
+        for (unsigned int mx = 0; mx < map.grid.width; ++mx) {
+            if (map.grid.data[my * map.grid.width + mx] < 99) {
+                continue;
+            }
+            double dx = map.grid.origin_x + (mx + 0.5) * map.grid.resolution - map.robot_pose.x;
+            double dy = map.grid.origin_y + (my + 0.5) * map.grid.resolution - map.robot_pose.y;
+            map.obstacles.push_back(pcl::PointXYZ(cos_th * dx + sin_th * dy, -sin_th * dx + cos_th * dy, 0));
+        }
+    }
+}
+
+/**
+ * 20 m square grid, robot in the middle, a 5 m wide corridor ahead with a few cone-sized obstacles in it
+ */
+BenchmarkMap MakeSyntheticMap() {
+    BenchmarkMap map;
+    map.name = "synthetic";
+    map.grid.resolution = 0.05;
+    map.grid.width = map.grid.height = 400;
+    map.grid.origin_x = map.grid.origin_y = -10.0;
+    map.grid.data.assign(map.grid.width * map.grid.height, 0);
+    map.robot_pose = rr::Pose(0, 0, 0);
+
+    auto mark = [&map](double x, double y) {
+        auto mx = static_cast<int>((x - map.grid.origin_x) / map.grid.resolution);
+        auto my = static_cast<int>((y - map.grid.origin_y) / map.grid.resolution);
+        if (mx >= 0 && my >= 0 && mx < static_cast<int>(map.grid.width) && my < static_cast<int>(map.grid.height)) {
+            map.grid.data[my * map.grid.width + mx] = 100;
+        }
+    };
+
+    for (double x = -2.0; x < 10.0; x += map.grid.resolution) {
+        mark(x, 2.5);
+        mark(x, -2.5);
+    }
+
+    std::mt19937 rand_gen(5);
+    std::uniform_real_distribution<double> cone_x(3.0, 10.0);
+    std::uniform_real_distribution<double> cone_y(-2.0, 2.0);
+    for (int cone = 0; cone < 6; ++cone) {
+        double cx = cone_x(rand_gen);
+        double cy = cone_y(rand_gen);
+        for (double dx = -0.15; dx <= 0.15; dx += map.grid.resolution) {
+            for (double dy = -0.15; dy <= 0.15; dy += map.grid.resolution) {
+                mark(cx + dx, cy + dy);
+            }
+        }
+    }
+
+    FillObstacles(map);
+    return map;
+}
+
+bool LoadRecordedMap(const std::string& path, double resolution, BenchmarkMap& map) {
+    cv::Mat image = cv::imread(path, cv::IMREAD_GRAYSCALE);
+    if (image.empty()) {
+        return false;
+    }
+
+    map.name = path;
+    map.grid.resolution = resolution;
+    map.grid.width = image.cols;
+    map.grid.height = image.rows;
+    map.grid.origin_x = -0.5 * image.cols * resolution;
+    map.grid.origin_y = -0.5 * image.rows * resolution;
+    map.grid.data.resize(image.total());
+    for (int r = 0; r < image.rows; ++r) {
+        for (int c = 0; c < image.cols; ++c) {
+            uint8_t value = image.at<uint8_t>(r, c);
+            map.grid.data[r * image.cols + c] = (value > 100) ? -1 : static_cast<int8_t>(value);
+        }
+    }
+    map.robot_pose = rr::Pose(0, 0, 0);
+
+    FillObstacles(map);
+    return true;
+}
+
+std::shared_ptr<rr::BicycleModel> MakeVehicleModel(int lookup_table_size = 0) {
+    auto steer_model = std::make_shared<rr::LinearTrackingFilter>(steer_filter_params);
+    auto speed_model = std::make_shared<rr::LinearTrackingFilter>(speed_filter_params);
+    speed_model->Reset(5.0, 0);
+    rr::BicycleModel::Params params = bicycle_params;
+    params.lookup_table_size = lookup_table_size;
+    return std::make_shared<rr::BicycleModel>(params, steer_model, speed_model);
+}
+
+std::unique_ptr<rr::MapCostInterface> MakeMapCost(const std::string& map_type, const BenchmarkMap& map) {
+    if (map_type == "distance_map") {
+        auto map_cost = std::make_unique<rr::DistanceMap>(rr::DistanceMap::Params{ hitbox, 0.2, 0.3 });
+        map_cost->SetMap(map.grid, map.robot_pose);
+        return map_cost;
+    } else if (map_type == "inflation_map") {
+        auto map_cost = std::make_unique<rr::InflationMap>(rr::InflationMap::Params{ hitbox, 98 });
+        map_cost->SetMap(map.grid, map.robot_pose);
+        return map_cost;
+    } else {
+        rr::NearestPointCache::Params params{ rr::Rectangle(-5, 10, -8, 8), hitbox, 0.2, 0.6 };
+        auto map_cost = std::make_unique<rr::NearestPointCache>(params);
+        map_cost->SetMap(map.obstacles);
+        return map_cost;
+    }
+}
+
+rr::Matrix<ctrl_dim, 2> ControlLimits() {
+    rr::Matrix<ctrl_dim, 2> ctrl_limits;
+    ctrl_limits << steer_filter_params.val_min, steer_filter_params.val_max;
+    return ctrl_limits;
+}
+
+void BM_RollOutPath(benchmark::State& state) {
+    auto model = MakeVehicleModel(state.range(1));
+    std::mt19937 rand_gen(1);
+    rr::Controls<ctrl_dim> controls = rr::init_controls<ctrl_dim>(state.range(0), ControlLimits(), rand_gen);
+    rr::TrajectoryRollout rollout;
+
+    for (auto _ : state) {
+        model->RollOutPath(controls, rollout);
+        benchmark::DoNotOptimize(rollout.path.x.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * rollout.path.size());
+}
+BENCHMARK(BM_RollOutPath)->Args({ 3, 0 })->Args({ 7, 0 })->Args({ 10, 0 })->Args({ 7, 256 });
+
+void BM_SetMap(benchmark::State& state, const std::string& map_type, const BenchmarkMap* map) {
+    for (auto _ : state) {
+        auto map_cost = MakeMapCost(map_type, *map);
+        benchmark::DoNotOptimize(map_cost.get());
+    }
+}
+
+void BM_DistanceCost(benchmark::State& state, const std::string& map_type, const BenchmarkMap* map) {
+    auto model = MakeVehicleModel();
+    auto map_cost = MakeMapCost(map_type, *map);
+    std::mt19937 rand_gen(1);
+    rr::Controls<ctrl_dim> controls = rr::init_controls<ctrl_dim>(n_segments, ControlLimits(), rand_gen);
+    rr::TrajectoryRollout rollout;
+    model->RollOutPath(controls, rollout);
+
+    for (auto _ : state) {
+        auto costs = map_cost->DistanceCost(rollout.path);
+        benchmark::DoNotOptimize(costs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * rollout.path.size());
+}
+
+template <typename Optimizer>
+void BM_Optimize(benchmark::State& state, const typename Optimizer::Params& params, const std::string& map_type,
+                 const BenchmarkMap* map) {
+    auto model = MakeVehicleModel();
+    auto map_cost = MakeMapCost(map_type, *map);
+    Optimizer optimizer(params);
+    const auto ctrl_limits = ControlLimits();
+
+    std::atomic<size_t> evaluations = 0;
+    auto cost_fn = rr::MakeCostFunction(*model, *map_cost, cost_weights, speed_filter_params.val_max);
+    rr::CostFunction<ctrl_dim> counting_cost_fn = [&](const rr::Controls<ctrl_dim>& controls) {
+        evaluations++;
+        return cost_fn(controls);
+    };
+
+    rr::Controls<ctrl_dim> init(ctrl_dim, n_segments);
+    init.setZero();
+    rr::real_t cost = 0;
+    for (auto _ : state) {
+        auto controls = optimizer.Optimize(counting_cost_fn, init, ctrl_limits);
+        cost = cost_fn(controls);
+        benchmark::DoNotOptimize(cost);
+    }
+    state.counters["cost"] = cost;
+    state.counters["evaluations"] = benchmark::Counter(evaluations.load(), benchmark::Counter::kIsRate);
+}
+
+void RegisterMapBenchmarks(const BenchmarkMap* map) {
+    rr::AnnealingOptimizer<ctrl_dim>::Params annealing_params;
+    annealing_params.annealing_steps = 1000;
+    annealing_params.temperature_end = 0.1;
+    annealing_params.stddev_start << 0.2;
+    annealing_params.acceptance_scale = 0.01;
+
+    auto tempering_params = annealing_params;
+    tempering_params.num_chains = 4;
+
+    auto batch_params = annealing_params;
+    batch_params.batch_size = 4;
+
+    rr::HillClimbOptimizer<ctrl_dim>::Params hill_climb_params;
+    hill_climb_params.num_workers = 6;
+    hill_climb_params.num_restarts = 12;
+    hill_climb_params.neighbor_stddev << 0.015;
+    hill_climb_params.local_optimum_tries = 60;
+
+    for (const std::string map_type : { "distance_map", "inflation_map", "obstacle_points" }) {
+        const std::string suffix = "/" + map_type + "/" + map->name;
+        benchmark::RegisterBenchmark(("BM_SetMap" + suffix).c_str(), BM_SetMap, map_type, map)
+              ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("BM_DistanceCost" + suffix).c_str(), BM_DistanceCost, map_type, map);
+        benchmark::RegisterBenchmark(("BM_Optimize/annealing" + suffix).c_str(),
+                                     BM_Optimize<rr::AnnealingOptimizer<ctrl_dim>>, annealing_params, map_type, map)
+              ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("BM_Optimize/tempering" + suffix).c_str(),
+                                     BM_Optimize<rr::AnnealingOptimizer<ctrl_dim>>, tempering_params, map_type, map)
+              ->Unit(benchmark::kMillisecond)
+              ->UseRealTime();
+        benchmark::RegisterBenchmark(("BM_Optimize/batch_annealing" + suffix).c_str(),
+                                     BM_Optimize<rr::AnnealingOptimizer<ctrl_dim>>, batch_params, map_type, map)
+              ->Unit(benchmark::kMillisecond)
+              ->UseRealTime();
+        benchmark::RegisterBenchmark(("BM_Optimize/hill_climbing" + suffix).c_str(),
+                                     BM_Optimize<rr::HillClimbOptimizer<ctrl_dim>>, hill_climb_params, map_type, map)
+              ->Unit(benchmark::kMillisecond)
+              ->UseRealTime();
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+
+    double resolution = 0.05;
+    std::vector<std::string> map_files;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const std::string resolution_flag = "--map_resolution=";
+        if (arg.rfind(resolution_flag, 0) == 0) {
+            resolution = std::stod(arg.substr(resolution_flag.size()));
+        } else {
+            map_files.push_back(arg);
+        }
+    }
+
+    g_maps.reserve(1 + map_files.size());
+    g_maps.push_back(MakeSyntheticMap());
+    for (const auto& file : map_files) {
+        BenchmarkMap map;
+        if (LoadRecordedMap(file, resolution, map)) {
+            g_maps.push_back(std::move(map));
+        } else {
+            std::cerr << "could not load recorded map " << file << std::endl;
+            return 1;
+        }
+    }
+
+    for (const auto& map : g_maps) {
+        RegisterMapBenchmarks(&map);
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
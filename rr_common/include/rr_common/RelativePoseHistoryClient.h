@@ -3,6 +3,11 @@
 #include <geometry_msgs/Pose2D.h>
 #include <nav_msgs/Path.h>
 #include <ros/ros.h>
+#include <rr_common/SharedPoseHistory.h>
+
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace rr {
 
@@ -20,15 +25,39 @@ class RelativePoseHistoryClient {
     Pose GetRelativePoseAtTime(const ros::Time& t);
 
     /**
-     * Register callback for /pose_history topic
-     * @param handle NodeHandle to use for subscription
+     * Get the motion between two (recent) past times, interpolated like GetRelativePoseAtTime. Unlike differencing two
+     * of its results, this is unaffected by the history advancing between the calls
+     * @param from time of the reference frame
+     * @param to time of the pose
+     * @return Pose (x, y, theta) at time to in the local frame at time from
+     */
+    Pose GetRelativePose(const ros::Time& from, const ros::Time& to);
+
+    /**
+     * Attach to the history that pose_tracker_server shares with processes on this host. Either may start first.
+     * While the shared memory can't be opened, or stays empty (e.g. the server runs on another host), poses come from
+     * the coarser /pose_history topic instead
+     * @param nh NodeHandle for the /pose_history subscription; its queue runs the callback
+     * @param segment_name Shared memory segment the server writes
      */
-    ros::Subscriber RegisterCallback(ros::NodeHandle& handle);
+    void Attach(ros::NodeHandle& nh, const std::string& segment_name = SharedPoseHistory::kDefaultName);
 
   private:
-    void callback(const nav_msgs::PathConstPtr& path_msg);
+    /**
+     * Read the history from /pose_history until the shared memory has some
+     * @return whether either source has poses
+     */
+    bool UseFallbackIfEmpty();
+
+    void FallbackCallback(const nav_msgs::PathConstPtr& path_msg);
+
+    bool GetNewest(PoseRecord& out) const;
+    bool Interpolate(double time, PoseRecord& out) const;
 
-    nav_msgs::PathConstPtr history_;
+    std::unique_ptr<SharedPoseHistory> history_;
+    ros::NodeHandle nh_;
+    ros::Subscriber fallback_sub_;
+    std::vector<PoseRecord> fallback_history_;  // from the topic, in time order, in the newest message's frame
 };
 
 }  // namespace rr
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace rr {
+
+/**
+ * One pose of the vehicle's past path
+ */
+struct PoseRecord {
+    double time;  // seconds
+    double x;
+    double y;
+    double yaw;
+};
+
+/**
+ * @return pose b in the frame of pose a, i.e. a^-1 * b, stamped with b's time
+ */
+inline PoseRecord RelativePose(const PoseRecord& a, const PoseRecord& b) {
+    const double c = std::cos(a.yaw);
+    const double s = std::sin(a.yaw);
+    const double dx = b.x - a.x;
+    const double dy = b.y - a.y;
+    return { b.time, c * dx + s * dy, -s * dx + c * dy, std::remainder(b.yaw - a.yaw, 2 * M_PI) };
+}
+
+/**
+ * @return pose at a time between p1's and p2's, linearly interpolated
+ */
+inline PoseRecord InterpolatePose(const PoseRecord& p1, const PoseRecord& p2, double time) {
+    const double lambda = p2.time > p1.time ? (time - p1.time) / (p2.time - p1.time) : 0;
+    return { time, p1.x + lambda * (p2.x - p1.x), p1.y + lambda * (p2.y - p1.y),
+             std::remainder(p1.yaw + lambda * std::remainder(p2.yaw - p1.yaw, 2 * M_PI), 2 * M_PI) };
+}
+
+/**
+ * Pose history shared between processes on one host through a named shared memory segment.
+ *
+ * The segment holds a fixed-size ring buffer of PoseRecords in time order, so lookups are a binary search with no
+ * message parsing. One process writes; readers never block it. Writes are guarded by a sequence lock: a reader that
+ * overlaps a write notices the sequence number change and retries.
+ */
+class SharedPoseHistory {
+  public:
+    static constexpr size_t kCapacity = 16384;
+    static constexpr const char* kDefaultName = "/rr_pose_history";
+    static constexpr int kMaxReadAttempts = 1000;  // before a read gives up on a writer that never finishes
+
+    /**
+     * Map a segment, creating it empty if no process has yet
+     * @param name Shared memory object name, starting with '/'
+     * @param writer Whether this is the single writer. The segment outlives its processes, so the writer resets the
+     *        sequence lock, in case a previous writer died mid-write
+     * @throws std::runtime_error if the segment can't be opened or mapped
+     */
+    explicit SharedPoseHistory(const std::string& name = kDefaultName, bool writer = false);
+    ~SharedPoseHistory();
+
+    SharedPoseHistory(const SharedPoseHistory&) = delete;
+    SharedPoseHistory& operator=(const SharedPoseHistory&) = delete;
+
+    /**
+     * Replace the history. Only the newest kCapacity records are kept. Single writer only
+     * @param records Poses in increasing time order
+     * @param count Number of records
+     */
+    void Assign(const PoseRecord* records, size_t count);
+
+    /**
+     * Add a record newer than all others, dropping the oldest once full. Single writer only
+     */
+    void Append(const PoseRecord& record);
+
+    /**
+     * Pose at a time, linearly interpolated between the records around it. Times outside the history get the oldest
+     * or newest record
+     * @return false if the history is empty, or no consistent read was possible in kMaxReadAttempts tries
+     */
+    bool Interpolate(double time, PoseRecord& out) const;
+
+    /**
+     * @return false if the history is empty, or no consistent read was possible in kMaxReadAttempts tries
+     */
+    bool GetNewest(PoseRecord& out) const;
+
+  private:
+    struct Segment;
+
+    void BeginWrite();
+    void EndWrite();
+
+    Segment* segment_;
+};
+
+}  // namespace rr
@@ -1,7 +1,7 @@
 #pragma once
 
-#include <parameter_assertions/assertions.h>
-#include <ros/ros.h>
+#include <algorithm>
+#include <iostream>
 
 namespace rr {
 
@@ -16,21 +16,31 @@ class LinearTrackingFilter {
     double last_update_;
 
   public:
-    explicit LinearTrackingFilter(const ros::NodeHandle& nh) {
-        assertions::getParam(nh, "init_val", val_);
-        target_ = val_;
-        assertions::getParam(nh, "val_max", val_max_);
-        assertions::getParam(nh, "val_min", val_min_, { assertions::less(val_max_) });
-        assertions::getParam(nh, "rate_min", rate_min_, { assertions::less<double>(0) });
-        assertions::getParam(nh, "rate_max", rate_max_, { assertions::greater<double>(0) });
-        last_update_ = 0;
-    }
+    struct Params {
+        double init_val;  // value before the first update
+        double val_min;   // lower bound on the value
+        double val_max;   // upper bound on the value
+        double rate_min;  // most negative rate of change, per second
+        double rate_max;  // most positive rate of change, per second
+    };
+
+    explicit LinearTrackingFilter(const Params& params)
+          : val_(params.init_val)
+          , target_(params.init_val)
+          , val_min_(params.val_min)
+          , val_max_(params.val_max)
+          , rate_min_(params.rate_min)
+          , rate_max_(params.rate_max)
+          , last_update_(0) {}
 
     LinearTrackingFilter(const LinearTrackingFilter& t) = default;
 
     inline double GetValue() const {
         return val_;
     }
+    inline double GetTarget() const {
+        return target_;
+    }
     inline double GetLastUpdateTime() const {
         return last_update_;
     }
@@ -58,8 +68,8 @@ class LinearTrackingFilter {
                 val_ = std::clamp(target_, val_ + rate_min_ * dt, val_ + rate_max_ * dt);
                 val_ = std::clamp(val_, val_min_, val_max_);
             } else if (dt < 0) {
-                ROS_WARN("[%s] linear tracking model found jump backwards in time %f %f",
-                         ros::this_node::getName().c_str(), last_update_, t);
+                std::cerr << "[LinearTrackingFilter] found jump backwards in time " << last_update_ << " " << t
+                          << std::endl;
             }
         }
 
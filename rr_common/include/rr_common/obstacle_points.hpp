@@ -0,0 +1,126 @@
+#pragma once
+
+#include <rr_msgs/obstacle_points.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/point_cloud2_iterator.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <rr_common/point_cloud_view.hpp>
+#include <utility>
+
+namespace rr {
+
+/*
+ * Obstacle points:
+ * - planar obstacle points travel as rr_msgs/obstacle_points, int16 fixed point at 4 bytes a point, where a
+ *   PointCloud2 of pcl::PointXYZ takes 16
+ * - encoding rounds to the nearest multiple of the resolution, and drops points beyond its range and NaNs
+ * - ObstaclePoints reads either message form, so consumers can take clouds from nodes that only publish PointCloud2
+ */
+
+constexpr float kObstacleResolution = 0.01f;  // meters; covers +/- 327 m
+
+/**
+ * @param points Range of points with x and y members, such as a pcl::PointCloud
+ * @param msg Output; the header is left to the caller
+ */
+template <typename Points>
+void EncodeObstaclePoints(const Points& points, float resolution, rr_msgs::obstacle_points& msg) {
+    constexpr float limit = std::numeric_limits<int16_t>::max();
+    const float scale = 1.0f / resolution;
+
+    msg.resolution = resolution;
+    msg.points.clear();
+    msg.points.reserve(2 * points.size());
+    for (const auto& p : points) {
+        const float x = std::round(p.x * scale);
+        const float y = std::round(p.y * scale);
+        if (std::abs(x) <= limit && std::abs(y) <= limit) {
+            msg.points.push_back(static_cast<int16_t>(x));
+            msg.points.push_back(static_cast<int16_t>(y));
+        }
+    }
+}
+
+/**
+ * Write points as a PointCloud2 with the same x, y, z layout as a pcl::PointXYZ cloud, with z = 0
+ * @param points Range of points with x and y members
+ * @param msg Output; the header is left to the caller
+ */
+template <typename Points>
+void WriteObstacleCloud(const Points& points, sensor_msgs::PointCloud2& msg) {
+    sensor_msgs::PointCloud2Modifier modifier(msg);
+    modifier.setPointCloud2FieldsByString(1, "xyz");
+    modifier.resize(points.size());
+
+    sensor_msgs::PointCloud2Iterator<float> out_x(msg, "x");
+    sensor_msgs::PointCloud2Iterator<float> out_y(msg, "y");
+    sensor_msgs::PointCloud2Iterator<float> out_z(msg, "z");
+    for (const auto& p : points) {
+        *out_x = p.x;
+        *out_y = p.y;
+        *out_z = 0;
+        ++out_x;
+        ++out_y;
+        ++out_z;
+    }
+}
+
+/**
+ * Obstacle points received in either message form. Holds the message, so it can be kept past its callback
+ */
+class ObstaclePoints {
+  public:
+    ObstaclePoints() = default;
+    explicit ObstaclePoints(rr_msgs::obstacle_pointsConstPtr msg) : compact_(std::move(msg)) {}
+    explicit ObstaclePoints(sensor_msgs::PointCloud2ConstPtr msg) : cloud_(std::move(msg)) {}
+
+    /**
+     * @return false if default constructed, with no message
+     */
+    [[nodiscard]] bool valid() const {
+        return compact_ || cloud_;
+    }
+
+    [[nodiscard]] const std_msgs::Header& header() const {
+        static const std_msgs::Header no_header{};
+        return compact_ ? compact_->header : cloud_ ? cloud_->header : no_header;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return size() == 0;
+    }
+
+    [[nodiscard]] size_t size() const {
+        if (compact_) {
+            return compact_->points.size() / 2;
+        }
+        return cloud_ ? PointCloudXYView(*cloud_).size() : 0;
+    }
+
+    /**
+     * Call fn(x, y) for every point, decoding in place from the message
+     */
+    template <typename Fn>
+    void ForEach(Fn fn) const {
+        if (compact_) {
+            const float resolution = compact_->resolution;
+            const auto& points = compact_->points;
+            for (size_t i = 0; i + 1 < points.size(); i += 2) {
+                fn(points[i] * resolution, points[i + 1] * resolution);
+            }
+        } else if (cloud_) {
+            for (const auto& p : PointCloudXYView(*cloud_)) {
+                fn(p.x, p.y);
+            }
+        }
+    }
+
+  private:
+    rr_msgs::obstacle_pointsConstPtr compact_;
+    sensor_msgs::PointCloud2ConstPtr cloud_;
+};
+
+}  // namespace rr
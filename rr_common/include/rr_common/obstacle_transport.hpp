@@ -0,0 +1,131 @@
+#pragma once
+
+#include <ros/master.h>
+#include <ros/ros.h>
+#include <rr_msgs/obstacle_points.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <functional>
+#include <rr_common/obstacle_points.hpp>
+#include <string>
+#include <vector>
+
+namespace rr {
+
+/*
+ * Obstacle topics:
+ * - ObstaclePublisher offers points on a topic as a PointCloud2, for rviz and nodes outside rr_common, and on the
+ *   topic's "/compact" subtopic as rr_msgs/obstacle_points. Each form is only encoded when it has subscribers
+ * - ObstacleSubscriber takes the compact form when the master lists it, and the PointCloud2 otherwise. Until the
+ *   compact form appears, it checks the master for it once a second, so publishers may start later. The checks end
+ *   after kMaxCompactChecks, or with one last check when a PointCloud2 arrives, since an ObstaclePublisher advertises
+ *   both forms before publishing either
+ */
+
+inline std::string CompactObstacleTopic(const std::string& topic) {
+    return topic + "/compact";
+}
+
+class ObstaclePublisher {
+  public:
+    ObstaclePublisher() = default;
+
+    ObstaclePublisher(ros::NodeHandle& nh, const std::string& topic, float resolution = kObstacleResolution)
+          : cloud_pub_(nh.advertise<sensor_msgs::PointCloud2>(topic, 1))
+          , compact_pub_(nh.advertise<rr_msgs::obstacle_points>(CompactObstacleTopic(topic), 1))
+          , resolution_(resolution) {}
+
+    [[nodiscard]] bool HasSubscribers() const {
+        return cloud_pub_.getNumSubscribers() > 0 || compact_pub_.getNumSubscribers() > 0;
+    }
+
+    /**
+     * @param points Range of points with x and y members, such as a pcl::PointCloud
+     */
+    template <typename Points>
+    void Publish(const std_msgs::Header& header, const Points& points) {
+        if (compact_pub_.getNumSubscribers() > 0) {
+            rr_msgs::obstacle_pointsPtr msg(new rr_msgs::obstacle_points);
+            msg->header = header;
+            EncodeObstaclePoints(points, resolution_, *msg);
+            compact_pub_.publish(msg);
+        }
+        if (cloud_pub_.getNumSubscribers() > 0) {
+            sensor_msgs::PointCloud2Ptr msg(new sensor_msgs::PointCloud2);
+            msg->header = header;
+            WriteObstacleCloud(points, *msg);
+            cloud_pub_.publish(msg);
+        }
+    }
+
+  private:
+    ros::Publisher cloud_pub_;
+    ros::Publisher compact_pub_;
+    float resolution_ = kObstacleResolution;
+};
+
+class ObstacleSubscriber {
+  public:
+    using Callback = std::function<void(const ObstaclePoints&)>;
+
+    static constexpr int kMaxCompactChecks = 30;
+
+    ObstacleSubscriber() = default;
+    ObstacleSubscriber(const ObstacleSubscriber&) = delete;
+    ObstacleSubscriber& operator=(const ObstacleSubscriber&) = delete;
+
+    void Subscribe(ros::NodeHandle& nh, const std::string& topic, Callback callback) {
+        nh_ = nh;
+        topic_ = nh.resolveName(topic);
+        callback_ = std::move(callback);
+
+        if (!TrySubscribeCompact()) {
+            sub_ = nh_.subscribe<sensor_msgs::PointCloud2>(
+                  topic_, 1, [this](const sensor_msgs::PointCloud2ConstPtr& msg) {
+                      // the publisher is up, and advertised any compact form first; one last check settles it
+                      if (compact_checks_ < kMaxCompactChecks) {
+                          compact_checks_ = kMaxCompactChecks;
+                          retry_timer_.stop();
+                          TrySubscribeCompact();
+                      }
+                      callback_(ObstaclePoints(msg));
+                  });
+            compact_checks_ = 1;
+            retry_timer_ = nh_.createTimer(ros::Duration(1.0), [this](const ros::TimerEvent&) {
+                if (TrySubscribeCompact() || ++compact_checks_ >= kMaxCompactChecks) {
+                    retry_timer_.stop();
+                }
+            });
+        }
+    }
+
+  private:
+    bool TrySubscribeCompact() {
+        const std::string compact_topic = CompactObstacleTopic(topic_);
+        std::vector<ros::master::TopicInfo> topics;
+        if (!ros::master::getTopics(topics)) {
+            return false;
+        }
+        for (const auto& info : topics) {
+            if (info.name == compact_topic &&
+                info.datatype == ros::message_traits::datatype<rr_msgs::obstacle_points>()) {
+                // replaces the PointCloud2 subscription, if any
+                sub_ = nh_.subscribe<rr_msgs::obstacle_points>(
+                      compact_topic, 1,
+                      [this](const rr_msgs::obstacle_pointsConstPtr& msg) { callback_(ObstaclePoints(msg)); });
+                ROS_INFO_STREAM("Receiving compact obstacle points on " << compact_topic);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    ros::NodeHandle nh_;
+    std::string topic_;
+    Callback callback_;
+    ros::Subscriber sub_;
+    ros::Timer retry_timer_;
+    int compact_checks_ = 0;
+};
+
+}  // namespace rr
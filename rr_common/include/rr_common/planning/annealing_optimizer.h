@@ -1,11 +1,11 @@
 #pragma once
 
-#include <ros/node_handle.h>
-
+#include <memory>
 #include <random>
 #include <vector>
 
 #include "planning_optimizer.h"
+#include "worker_pool.h"
 
 namespace rr {
 
@@ -17,9 +17,13 @@ class AnnealingOptimizer : public PlanningOptimizer<ctrl_dim> {
         double temperature_end;         // temperature at last iteration
         Vector<ctrl_dim> stddev_start;  // neighbor standard deviation when temperature=1
         double acceptance_scale;        // strictness for accepting bad paths
+        int num_chains = 1;             // parallel tempering chains, one thread each; 1 runs a single chain
+        int swap_interval = 50;         // steps between state exchanges of adjacent tempering chains
+        int batch_size = 1;             // neighbors proposed and scored in parallel per step, single chain only
+        bool batch_sample = false;      // Metropolis on a Boltzmann-sampled neighbor instead of the best one
     };
 
-    explicit AnnealingOptimizer(const ros::NodeHandle& nh);
+    explicit AnnealingOptimizer(const Params& params);
 
     ~AnnealingOptimizer() = default;
 
@@ -27,11 +31,27 @@ class AnnealingOptimizer : public PlanningOptimizer<ctrl_dim> {
                                 const Matrix<ctrl_dim, 2>& ctrl_limits) override;
 
   private:
-    double GetTemperature(unsigned int t);
+    real_t GetTemperature(unsigned int t);
+
+    /**
+     * Parallel tempering: run num_chains annealing chains on their own threads, chain c following the base schedule
+     * scaled by (1 / temperature_end)^(c / num_chains). Every swap_interval steps, adjacent chains exchange states
+     * with the replica exchange acceptance probability, so good states found by hot chains sink to cold ones
+     */
+    Controls<ctrl_dim> OptimizeTempering(const CostFunction<ctrl_dim>& cost_fn, const Controls<ctrl_dim>& init_controls,
+                                         const Matrix<ctrl_dim, 2>& ctrl_limits);
+
+    /**
+     * Batch proposals: each step scores batch_size neighbors of the current state on the worker pool and applies
+     * the Metropolis test to one of them, taking annealing_steps / batch_size steps in total
+     */
+    Controls<ctrl_dim> OptimizeBatch(const CostFunction<ctrl_dim>& cost_fn, const Controls<ctrl_dim>& init_controls,
+                                     const Matrix<ctrl_dim, 2>& ctrl_limits);
 
     Params params_;
     std::uniform_real_distribution<double> uniform_01_;
     std::mt19937 rand_gen_;
+    std::unique_ptr<WorkerPool> worker_pool_;  // only for batch proposals
 };
 
 }  // namespace rr
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <memory>
 #include <rr_common/linear_tracking_filter.hpp>
 #include <tuple>
+#include <vector>
 
 #include "planner_types.hpp"
 
@@ -9,19 +11,23 @@ namespace rr {
 
 class BicycleModel {
   public:
+    struct Params {
+        double wheel_base;          // distance from front axle to back axle
+        double lateral_accel;       // maximum acceptable centripetal acceleration
+        int segment_size;           // number of rollout steps per control segment
+        double dt;                  // time between consecutive path points in rollout
+        int lookup_table_size = 0;  // steering grid points of precomputed kinematics; 0 computes them directly
+        bool reverse = false;       // drive backwards, at up to the speed filter's minimum speed
+    };
+
     /**
      * Constructor. Units are metric standard: m, m/s, m/s^2, rad/s
-     * @param wheel_base Distance from front axle to back axle
-     * @param max_lateral_accel Maximum acceptable centripetal acceleration
-     * @param distance_increment Distance between consecutive path points in
-     * rollout
-     * @param max_speed Straight-line desired speed
-     * @param max_steer_rate Rate at which the platform can change its steering
-     * angle
-     * @param segment_sections Vector of sizes of
+     * @param params Vehicle and rollout parameters
+     * @param steer_model_ptr Filter tracking the platform's steering angle
+     * @param speed_model_ptr Filter tracking the platform's speed
      */
-    explicit BicycleModel(const ros::NodeHandle& nh, const std::shared_ptr<rr::LinearTrackingFilter>& steer_model_ptr,
-                          const std::shared_ptr<rr::LinearTrackingFilter>& speed_model_ptr);
+    BicycleModel(const Params& params, const std::shared_ptr<rr::LinearTrackingFilter>& steer_model_ptr,
+                 const std::shared_ptr<rr::LinearTrackingFilter>& speed_model_ptr);
 
     /**
      * roll out a trajectory through the world
@@ -40,24 +46,52 @@ class BicycleModel {
      * @param steer_angle Proposed steering value to publish
      * @return Maximum acceptable speed given the turning angle
      */
-    [[nodiscard]] double SteeringToSpeed(double steer_angle) const;
+    [[nodiscard]] real_t SteeringToSpeed(real_t steer_angle) const;
 
     /**
      * Calculate one distance-step (not timestep) of "simulated" vehicle motion.
      * Bicycle-model forward kinematics happens here.
-     * @param last_pose Initial (x,y,theta) for the distance step
-     * @param steer_angle Constant steering angle for the distance step
-     * @param pose Out param for the resulting pose
+     * @param path Path holding the previous point at index i - 1
+     * @param i Index of the point to write the resulting pose into
      */
-    void StepKinematics(const PathPoint& prev, Pose& next) const;
+    void StepKinematics(Path& path, size_t i) const;
 
-    double wheel_base_;
-    double max_lateral_accel_;
+    /**
+     * Exact motion over one step in the vehicle frame
+     * @param prev_steer Steering angle held over the step
+     * @param distance_increment Distance travelled, negative when reversing
+     * @param deltaX, deltaY, deltaTheta Output pose change
+     */
+    void ComputeStep(real_t prev_steer, real_t distance_increment, real_t& deltaX, real_t& deltaY,
+                     real_t& deltaTheta) const;
+
+    /**
+     * Tables over a uniform steering grid spanning the steering filter's limits, and over the distances one step
+     * can cover within the speed filter's limits, sampled from the exact functions and linearly interpolated
+     */
+    struct LookupTables {
+        real_t steer_min, steer_scale;  // steer grid index = (steer - steer_min) * steer_scale
+        real_t dist_min, dist_scale;    // distance grid index = (distance - dist_min) * dist_scale
+        int steer_size, dist_size;
+        std::vector<real_t> delta_x;       // steer-major, steer_size x dist_size
+        std::vector<real_t> delta_y;       // steer-major, steer_size x dist_size
+        std::vector<real_t> heading_rate;  // heading change per meter, per steer grid point
+        std::vector<real_t> sine;          // one period of sin, sine_size + 1 entries
+        int sine_size;
+    };
+
+    void BuildLookupTables(int steer_size);
+
+    real_t wheel_base_;
+    real_t max_lateral_accel_;
     int segment_size_;
-    double dt_;
+    real_t dt_;
+    bool reverse_;
 
     std::shared_ptr<rr::LinearTrackingFilter> steering_model_;
     std::shared_ptr<rr::LinearTrackingFilter> speed_model_;
+
+    std::shared_ptr<const LookupTables> tables_;  // null when computing kinematics directly
 };
 
 }  // namespace rr
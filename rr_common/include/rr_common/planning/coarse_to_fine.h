@@ -0,0 +1,80 @@
+/*
+ * Coarse-to-fine planning:
+ * - the configured optimizer explores globally with only a few long control segments, rolled out with a large
+ *   time step, so each cost evaluation is a fraction of a full-resolution one
+ * - the result is resampled to each finer segment count in turn and refined by local hill descent, ending at the
+ *   full segment count and full-resolution rollout
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "bicycle_model.h"
+#include "hill_climb_optimizer.h"
+#include "planner_types.hpp"
+#include "planning_optimizer.h"
+
+namespace rr {
+
+/**
+ * Resample piecewise-constant controls to a different number of equal-duration segments
+ * @param controls Controls spanning the planning horizon
+ * @param n_segments Segment count of the result
+ * @return controls spanning the same horizon, each segment taking the value at its center
+ */
+template <int ctrl_dim>
+Controls<ctrl_dim> ResampleControls(const Controls<ctrl_dim>& controls, int n_segments) {
+    Controls<ctrl_dim> resampled(ctrl_dim, n_segments);
+    for (int i = 0; i < n_segments; ++i) {
+        auto source = static_cast<long>((i + 0.5) * controls.cols() / n_segments);
+        resampled.col(i) = controls.col(source);
+    }
+    return resampled;
+}
+
+class CoarseToFinePlanner {
+  public:
+    struct Params {
+        std::vector<int> levels;  // segment counts of the coarse passes, coarsest first, all below n_segments
+        int dt_factor;            // coarse rollouts integrate with a time step this many times longer
+        Vector<1> refine_stddev;  // neighbor standard deviation of the local refinement at finer levels
+        int refine_tries;         // refinement stops after this many neighbors without improvement
+    };
+
+    using CostFunctionFactory = std::function<CostFunction<1>(const BicycleModel&)>;
+
+    /**
+     * @param params Schedule parameters
+     * @param model_params Parameters of the full-resolution vehicle model
+     * @param n_segments Full-resolution segment count
+     * @param steer_model_ptr Filter tracking the platform's steering angle
+     * @param speed_model_ptr Filter tracking the platform's speed
+     */
+    CoarseToFinePlanner(const Params& params, const BicycleModel::Params& model_params, int n_segments,
+                        const std::shared_ptr<rr::LinearTrackingFilter>& steer_model_ptr,
+                        const std::shared_ptr<rr::LinearTrackingFilter>& speed_model_ptr);
+
+    /**
+     * Run the schedule
+     * @param optimizer Global optimizer used at the coarsest level
+     * @param make_cost_fn Builds the cost function for a level from its vehicle model
+     * @param full_model Full-resolution vehicle model
+     * @param init_controls Full-resolution warm start
+     * @param ctrl_limits Control limits
+     * @return full-resolution controls
+     */
+    Controls<1> Optimize(PlanningOptimizer<1>& optimizer, const CostFunctionFactory& make_cost_fn,
+                         const BicycleModel& full_model, const Controls<1>& init_controls,
+                         const Matrix<1, 2>& ctrl_limits);
+
+  private:
+    std::vector<int> levels_;
+    std::vector<BicycleModel> coarse_models_;
+    HillClimbOptimizer<1> refiner_;
+    int n_segments_;
+};
+
+}  // namespace rr
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "planner_types.hpp"
+
+namespace rr {
+
+/**
+ * Clamped uniform B-spline over the planning horizon. A few knots (control points) are expanded into the
+ * per-segment steering targets that BicycleModel rolls out, so optimizers can search the smaller knot space and
+ * every candidate is smooth. Segment targets are samples of the spline at segment centers; since a B-spline stays
+ * within the convex hull of its knots, knots within the control limits give targets within the limits.
+ */
+template <int ctrl_dim>
+class ControlSpline {
+  public:
+    /**
+     * @param n_knots Number of knots the optimizer searches over
+     * @param n_segments Number of rollout segments, at most the column limit of Controls
+     * @param degree Spline degree, reduced to n_knots - 1 if there are too few knots
+     */
+    ControlSpline(int n_knots, int n_segments, int degree = 3);
+
+    /**
+     * Expand knots into per-segment controls
+     * @param knots ctrl_dim x n_knots
+     * @return ctrl_dim x n_segments
+     */
+    [[nodiscard]] Controls<ctrl_dim> Evaluate(const Controls<ctrl_dim>& knots) const;
+
+    /**
+     * Least-squares knots reproducing per-segment controls, e.g. to warm start from the previous plan
+     * @param segments ctrl_dim x n_segments
+     * @param limits Knots are clamped to these control limits
+     * @return ctrl_dim x n_knots
+     */
+    [[nodiscard]] Controls<ctrl_dim> Fit(const Controls<ctrl_dim>& segments, const Matrix<ctrl_dim, 2>& limits) const;
+
+    /**
+     * Cost function over knots, evaluating cost_fn on the expanded controls. Refers to this spline, which must
+     * outlive it
+     */
+    [[nodiscard]] CostFunction<ctrl_dim> Wrap(const CostFunction<ctrl_dim>& cost_fn) const;
+
+    [[nodiscard]] int GetNumKnots() const {
+        return static_cast<int>(basis_.rows());
+    }
+    [[nodiscard]] int GetNumSegments() const {
+        return static_cast<int>(basis_.cols());
+    }
+
+  private:
+    Eigen::Matrix<real_t, Eigen::Dynamic, Eigen::Dynamic> basis_;  // n_knots x n_segments, segments = knots * basis_
+    Eigen::Matrix<real_t, Eigen::Dynamic, Eigen::Dynamic> fit_;    // n_segments x n_knots right pseudo-inverse
+};
+
+}  // namespace rr
@@ -0,0 +1,66 @@
+/*
+ * CostCache:
+ * - memoizes trajectory costs of control candidates within one plan, keyed by the controls quantized to a
+ *   configurable resolution, so clamped or converged candidates that repeat skip their rollout
+ * - fixed-size open-addressing table; lookups and insertions from optimizer worker threads are lock-free
+ * - keys are 64-bit hashes of the quantized controls and of the wrapped cost function, so candidates of different
+ *   cost functions (e.g. coarse-to-fine levels) never share a cost, and two distinct candidates only do on a hash
+ *   collision, which is negligible at the table sizes used here
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "planner_types.hpp"
+
+namespace rr {
+
+template <int ctrl_dim>
+class CostCache {
+  public:
+    /**
+     * @param capacity Table size, rounded up to a power of two. Once full, new candidates are evaluated uncached
+     * @param resolution Controls closer than this in every element share a cost
+     */
+    CostCache(size_t capacity, double resolution);
+
+    /**
+     * Forget all entries; call between plans since costs depend on the map and vehicle state
+     */
+    void Clear();
+
+    /**
+     * Cost function that answers from the cache when possible and stores new results. Each call keys its entries
+     * apart from those of every other call since the last Clear. Refers to this cache, which must outlive it
+     */
+    [[nodiscard]] CostFunction<ctrl_dim> Wrap(const CostFunction<ctrl_dim>& cost_fn);
+
+    [[nodiscard]] uint64_t GetHits() const {
+        return hits_.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] uint64_t GetMisses() const {
+        return misses_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static constexpr int kMaxProbes = 16;
+
+    struct Entry {
+        std::atomic<uint64_t> key;  // 0 when empty
+        std::atomic<real_t> cost;   // NaN until the inserting thread stores the cost
+    };
+
+    [[nodiscard]] uint64_t Key(const Controls<ctrl_dim>& controls, uint64_t salt) const;
+
+    std::unique_ptr<Entry[]> table_;
+    size_t mask_;
+    double inverse_resolution_;
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> wraps_;  // since the last Clear, salting each wrapped function's keys
+};
+
+}  // namespace rr
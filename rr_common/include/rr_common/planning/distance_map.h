@@ -1,12 +1,5 @@
 #pragma once
 
-#include <geometry_msgs/PolygonStamped.h>
-#include <nav_msgs/OccupancyGrid.h>
-#include <parameter_assertions/assertions.h>
-#include <tf/tf.h>
-#include <tf/transform_datatypes.h>
-#include <tf/transform_listener.h>
-
 #include <opencv2/opencv.hpp>
 
 #include "map_cost_interface.h"
@@ -17,29 +10,55 @@ namespace rr {
 
 class DistanceMap : public MapCostInterface {
   public:
-    explicit DistanceMap(ros::NodeHandle nh);
+    struct Params {
+        Rectangle hitbox;            // footprint of the robot
+        double cost_scaling_factor;  // cost is 100 * e^(-distance * cost_scaling_factor)
+        double wall_inflation;       // extra clearance, beyond the inscribed circle, counted as collision
+    };
+
+    explicit DistanceMap(const Params& params);
+
+    real_t DistanceCost(const Pose& pose) override;
+
+    /**
+     * Build the distance cost field from an occupancy grid
+     * @param grid Occupancy grid. Cells with values in [99, 254] are obstacles
+     * @param robot_pose Pose of the robot base in the grid frame
+     */
+    void SetMap(const OccupancyGrid& grid, const Pose& robot_pose);
 
-    double DistanceCost(const Pose& pose) override;
+    [[nodiscard]] const cv::Mat& GetDistanceMap() const {
+        return distance_map;
+    }
+    [[nodiscard]] const cv::Mat& GetDistanceCostMap() const {
+        return distance_cost_map;
+    }
+    [[nodiscard]] double GetInscribedCircleRadius() const {
+        return inscribed_circle_radius;
+    }
+    [[nodiscard]] double GetInscribedCircleOrigin() const {
+        return inscribed_circle_origin;
+    }
+    [[nodiscard]] double GetWallInflation() const {
+        return wall_inflation;
+    }
 
   private:
     std::pair<unsigned int, unsigned int> PoseToGridPosition(const rr::Pose& pose);
-    void SetMapMessage(const nav_msgs::OccupancyGridConstPtr& map_msg);
 
-    ros::Subscriber map_sub;
-    std::string robot_base_frame;
-    ros::Publisher distance_map_pub;
-    ros::Publisher inscribed_circle_pub;
+    cv::Mat distance_map;
     cv::Mat distance_cost_map;
     Rectangle hit_box;
     double cost_scaling_factor;
     double wall_inflation;
     double inscribed_circle_radius;
     double inscribed_circle_origin;
-    bool publish_distance_map;
-    bool publish_inscribed_circle;
-    nav_msgs::MapMetaData mapMetaData;
-    std::unique_ptr<tf::TransformListener> listener;
-    tf::StampedTransform transform;
+    unsigned int map_width;
+    unsigned int map_height;
+    double map_resolution;
+    double map_origin_x;
+    double map_origin_y;
+    Pose robot_pose;
 };
 
 }  // namespace rr
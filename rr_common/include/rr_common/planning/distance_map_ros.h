@@ -0,0 +1,33 @@
+#pragma once
+
+#include <geometry_msgs/PolygonStamped.h>
+#include <nav_msgs/OccupancyGrid.h>
+#include <ros/ros.h>
+#include <tf/transform_listener.h>
+
+#include "distance_map.h"
+
+namespace rr {
+
+/**
+ * ROS adapter for DistanceMap: subscribes to an occupancy grid, looks up the robot pose in the map frame, and
+ * optionally publishes the resulting cost map and inscribed circle for debugging
+ */
+class DistanceMapRos : public DistanceMap {
+  public:
+    explicit DistanceMapRos(ros::NodeHandle nh);
+
+  private:
+    void SetMapMessage(const nav_msgs::OccupancyGridConstPtr& map_msg);
+
+    ros::Subscriber map_sub;
+    std::string robot_base_frame;
+    ros::Publisher distance_map_pub;
+    ros::Publisher inscribed_circle_pub;
+    bool publish_distance_map;
+    bool publish_inscribed_circle;
+    std::unique_ptr<tf::TransformListener> listener;
+    tf::StampedTransform transform;
+};
+
+}  // namespace rr
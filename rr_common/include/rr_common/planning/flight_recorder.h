@@ -0,0 +1,99 @@
+/*
+ * FlightRecorder:
+ * - keeps the inputs and outputs of the last N planning cycles in a fixed-size ring
+ * - the planning thread records without locks or allocation; any other thread may dump concurrently
+ * - dumps are a flat binary file that planner_replay can load to reproduce individual cycles
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rr {
+
+/**
+ * One planning cycle. Plain data so that it can be copied through the ring and written to disk as-is
+ */
+struct PlanRecord {
+    static constexpr int kMaxControls = 20;  // ctrl_dim * n_segments
+
+    double stamp;      // wall time the cycle started, seconds
+    double map_stamp;  // header stamp of the map planned on; matches the message in a bag recorded alongside
+
+    // tracking filter state when planning started
+    double filter_time;
+    double steer_value;
+    double steer_target;
+    double speed_value;
+    double speed_target;
+
+    int32_t ctrl_dim;
+    int32_t n_segments;
+    double init_controls[kMaxControls];  // warm start given to the optimizer, row-major
+    double controls[kMaxControls];       // optimizer result, row-major
+
+    // forward plan, from controls
+    double cost;
+    int32_t has_collision;
+    uint32_t cost_evaluations;
+
+    // reverse plan, when enabled; reversing is set when it was the one executed
+    int32_t reversing;
+    int32_t reverse_has_collision;
+    double reverse_cost;
+
+    // per-phase wall times, milliseconds
+    double optimize_ms;
+    double rollout_ms;
+    double publish_ms;
+    double total_ms;
+};
+
+class FlightRecorder {
+  public:
+    /**
+     * @param capacity Number of most recent cycles retained
+     */
+    explicit FlightRecorder(size_t capacity);
+
+    /**
+     * Store a cycle, overwriting the oldest one. Only one thread may record
+     */
+    void Record(const PlanRecord& record);
+
+    /**
+     * Copy out the retained cycles, oldest first. Slots overwritten during the copy are skipped
+     */
+    [[nodiscard]] std::vector<PlanRecord> Snapshot() const;
+
+    /**
+     * Write a snapshot to a binary file
+     * @param path Output file
+     * @return number of records written
+     * @throws std::runtime_error if the file can't be written
+     */
+    size_t Dump(const std::string& path) const;
+
+    /**
+     * Read a file written by Dump()
+     * @throws std::runtime_error if the file is missing or not a compatible recording
+     */
+    static std::vector<PlanRecord> Load(const std::string& path);
+
+  private:
+    // sequence is odd while the slot is being written, and 2 * (index + 1) once record number index is complete
+    struct Slot {
+        std::atomic<uint64_t> sequence{ 0 };
+        PlanRecord record{};
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t capacity_;
+    std::atomic<uint64_t> count_;  // records ever written
+};
+
+}  // namespace rr
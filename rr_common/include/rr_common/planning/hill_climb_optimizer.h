@@ -1,8 +1,7 @@
 #pragma once
 
-#include <ros/node_handle.h>
-
 #include <optional>
+#include <random>
 
 #include "planning_optimizer.h"
 
@@ -11,16 +10,21 @@ namespace rr {
 template <int ctrl_dim>
 class HillClimbOptimizer : public PlanningOptimizer<ctrl_dim> {
   public:
-    explicit HillClimbOptimizer(const ros::NodeHandle& nh);
+    struct Params {
+        int num_workers;                   // number of threads to run in parallel
+        int num_restarts;                  // total number of hill descents to do
+        Vector<ctrl_dim> neighbor_stddev;  // standard deviation of noise added in neighbor function
+        int local_optimum_tries;           // we are at a local optimum if we try this many times with no improvement
+    };
+
+    explicit HillClimbOptimizer(const Params& params);
 
     Controls<ctrl_dim> Optimize(const CostFunction<ctrl_dim>& cost_fn, const Controls<ctrl_dim>& init_controls,
                                 const Matrix<ctrl_dim, 2>& ctrl_limits) override;
 
   private:
-    int num_workers_;                   // number of threads to run in parallel
-    int num_restarts_;                  // total number of hill descents to do
-    Vector<ctrl_dim> neighbor_stddev_;  // standard deviation of noise added in neighbor function
-    int local_optimum_tries_;           // we are at a local optimum if we try this many times with no improvement
+    Params params_;
+    std::mt19937 rand_gen_;  // seeds each worker's own generator
 };
 
 }  // namespace rr
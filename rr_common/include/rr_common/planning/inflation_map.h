@@ -1,11 +1,5 @@
 #pragma once
 
-#include <nav_msgs/OccupancyGrid.h>
-#include <parameter_assertions/assertions.h>
-#include <tf/tf.h>
-#include <tf/transform_datatypes.h>
-#include <tf/transform_listener.h>
-
 #include "map_cost_interface.h"
 #include "planner_types.hpp"
 #include "rectangle.hpp"
@@ -14,18 +8,26 @@ namespace rr {
 
 class InflationMap : public MapCostInterface {
   public:
-    explicit InflationMap(ros::NodeHandle nh);
+    struct Params {
+        Rectangle hitbox;      // footprint of the robot; lethal cells inside it are ignored
+        int lethal_threshold;  // cells with a higher cost than this are collisions
+    };
 
-    double DistanceCost(const Pose& pose) override;
+    explicit InflationMap(const Params& params);
 
-  private:
-    void SetMapMessage(const nav_msgs::OccupancyGridConstPtr& map_msg);
+    real_t DistanceCost(const Pose& pose) override;
 
-    ros::Subscriber map_sub;
-    nav_msgs::OccupancyGridConstPtr map;
+    /**
+     * Store the occupancy grid to look costs up from
+     * @param grid Inflated occupancy grid
+     * @param robot_pose Pose of the robot base in the grid frame
+     */
+    void SetMap(const OccupancyGrid& grid, const Pose& robot_pose);
+
+  private:
+    OccupancyGrid map;
     Rectangle hit_box;
-    std::unique_ptr<tf::TransformListener> listener;
-    tf::StampedTransform transform;
+    Pose robot_pose;
     int lethal_threshold;
 };
 
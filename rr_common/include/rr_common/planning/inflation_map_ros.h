@@ -0,0 +1,26 @@
+#pragma once
+
+#include <nav_msgs/OccupancyGrid.h>
+#include <ros/ros.h>
+#include <tf/transform_listener.h>
+
+#include "inflation_map.h"
+
+namespace rr {
+
+/**
+ * ROS adapter for InflationMap: subscribes to an inflated occupancy grid and looks up the robot pose in its frame
+ */
+class InflationMapRos : public InflationMap {
+  public:
+    explicit InflationMapRos(ros::NodeHandle nh);
+
+  private:
+    void SetMapMessage(const nav_msgs::OccupancyGridConstPtr& map_msg);
+
+    ros::Subscriber map_sub;
+    std::unique_ptr<tf::TransformListener> listener;
+    tf::StampedTransform transform;
+};
+
+}  // namespace rr
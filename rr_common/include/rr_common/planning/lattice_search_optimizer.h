@@ -0,0 +1,135 @@
+/*
+ * LatticeSearchOptimizer:
+ * - graph search over chains of motion lattice primitives, one per control segment, on the map cost field
+ * - states are binned by (x, y, heading, steering angle); a state reached again more expensively is pruned
+ * - anytime: repeated best-first searches with a shrinking heuristic weight, keeping the best plan found before the
+ *   deadline. The heuristic extrapolates the cheapest first step's cost per point, which is an estimate and not a
+ *   lower bound (the speed term falls as the vehicle speeds up), so plans carry no suboptimality guarantee
+ * - the plan can seed a local optimizer, which then only polishes the corridor the search found
+ * - optionally keeps the tree of evaluated primitives across plans: it is re-rooted at the vehicle's pose, found by
+ *   following the previous plan for the time since it was made, and a kept primitive is reused if the search starts
+ *   it from the same pose again and the new map agrees with it at a few re-checked points. Only new or invalidated
+ *   primitives are evaluated in full
+ * - with reuse, the first primitive is cut short at the tree's next segment time so that deeper states line up with
+ *   the kept ones; the chain is resampled to whole segments from now for the caller
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <rr_common/linear_tracking_filter.hpp>
+#include <unordered_map>
+#include <vector>
+
+#include "map_cost_interface.h"
+#include "motion_lattice.h"
+#include "planning_optimizer.h"
+#include "trajectory_cost.h"
+
+namespace rr {
+
+class LatticeSearchOptimizer : public PlanningOptimizer<1> {
+  public:
+    struct Params {
+        double deadline_ms;      // stop searching and return the best plan so far after this long
+        double xy_resolution;    // position bin size of the search states, meters
+        int theta_bins;          // heading bins of the search states, over a full turn
+        int num_controls;        // steering targets expanded from each state, evenly spaced over the lattice's grid
+        double epsilon_start;    // heuristic weight of the first search
+        double epsilon_step;     // heuristic weight decrease between searches, down to 1
+        int max_expansions;      // per search; bounds memory when the deadline is generous
+        int reuse_stride;        // keep primitives across plans, re-checking every this many points; 0 disables
+        double reuse_tolerance;  // relative change of the re-checked map cost that invalidates a kept primitive
+    };
+
+    /**
+     * @param params Search parameters
+     * @param lattice Primitives to chain; must outlive the optimizer
+     * @param map_cost Map scored against; must outlive the optimizer
+     * @param weights Cost term weights, as for MakeCostFunction
+     * @param steer_model_ptr Filter tracking the platform's steering angle
+     * @param speed_model_ptr Filter tracking the platform's speed
+     * @param local_optimizer If given, refines the search result, which is then its warm start
+     * @throws std::runtime_error if tree reuse is enabled for a lattice with more than 2^20 primitives
+     */
+    LatticeSearchOptimizer(const Params& params, const MotionLattice& lattice, MapCostInterface& map_cost,
+                           const CostWeights& weights, const std::shared_ptr<rr::LinearTrackingFilter>& steer_model_ptr,
+                           const std::shared_ptr<rr::LinearTrackingFilter>& speed_model_ptr,
+                           std::unique_ptr<PlanningOptimizer<1>> local_optimizer = nullptr);
+
+    /**
+     * Search for the cheapest chain of init_controls.cols() primitives. The result, or init_controls if it scores
+     * better under cost_fn, is returned directly or after refinement by the local optimizer
+     */
+    Controls<1> Optimize(const CostFunction<1>& cost_fn, const Controls<1>& init_controls,
+                         const Matrix<1, 2>& ctrl_limits) override;
+
+  private:
+    static constexpr real_t kSameStartTolerance = 1e-3;  // meters and radians; a reused verdict is this close to exact
+
+    struct Node {
+        real_t x, y, theta;   // end pose of the node's primitive
+        real_t steer, speed;  // vehicle state at that pose
+        real_t g;             // discounted cost from the root
+        int depth;            // number of primitives from the root
+        int parent;           // index into the node list, -1 for the root
+        int control_bin;      // steering target of the primitive leading here
+    };
+
+    /**
+     * One best-first search to a full-length chain
+     * @param first_size Path points of the first primitive, which may end early to keep to the tree's segment times
+     * @return node list index of the goal node, or -1 if none was reached
+     */
+    int Search(int n_segments, int first_size, real_t epsilon, std::chrono::steady_clock::time_point deadline,
+               std::vector<Node>& nodes);
+
+    /**
+     * Primitive evaluated from a start pose, kept across searches and plans
+     */
+    struct TreeEdge {
+        real_t x, y, theta;   // start pose, in the vehicle frame of the current plan
+        int primitive;        // MotionLattice::PrimitiveIndex
+        real_t map_cost;      // discounted from the primitive's start; -1 if it collides
+        real_t sampled_cost;  // the part of map_cost from the re-checked points
+        int cycle;            // plan in which map_cost was last evaluated or re-checked
+    };
+
+    /**
+     * Discounted map cost along the first size points of a primitive from a node's pose, reused from the tree when
+     * still valid. Only whole primitives are kept
+     * @return the cost relative to the primitive's start, or -1 if it collides
+     */
+    real_t PrimitiveMapCost(const Node& start, int primitive, const MotionLattice::PrimitivePoint* points, int size);
+
+    /**
+     * Move the edges kept from the previous plan into the current vehicle frame, and drop the rest
+     * @return path points to the tree's next segment time, which the search's first primitive ends at
+     */
+    int RerootTree();
+
+    [[nodiscard]] uint64_t PoseKey(real_t x, real_t y, real_t theta) const;
+    [[nodiscard]] uint64_t StateKey(const Node& node) const;
+
+    Params params_;
+    const MotionLattice& lattice_;
+    MapCostInterface& map_cost_;
+    CostWeights weights_;
+    std::shared_ptr<rr::LinearTrackingFilter> steering_model_;
+    std::shared_ptr<rr::LinearTrackingFilter> speed_model_;
+    std::unique_ptr<PlanningOptimizer<1>> local_optimizer_;
+
+    std::vector<real_t> discount_;  // TrajectoryCost weight of each path point, extended as needed
+    real_t cheapest_point_cost_;    // heuristic cost estimate per remaining path point, from the root's successors;
+                                    // -1 until computed for the current plan
+
+    std::vector<TreeEdge> tree_;
+    std::unordered_map<uint64_t, int> tree_index_;  // (start pose bin, primitive) to index into tree_
+    int cycle_;                                     // plans made so far
+    TrajectoryRollout last_rollout_;                // the previous plan, to follow to the current pose
+    double last_plan_time_;                         // steering filter time of the previous plan
+    double tree_time_;                              // steering filter time of one of the tree's segment ends
+};
+
+}  // namespace rr
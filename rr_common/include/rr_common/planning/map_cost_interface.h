@@ -7,36 +7,40 @@
 
 #pragma once
 
+#include <algorithm>
+
 #include "planner_types.hpp"
 
 namespace rr {
 
 class MapCostInterface {
   public:
-    MapCostInterface() : updated_(false), accepting_updates_(true) {}
+    MapCostInterface()
+          : updated_(false), accepting_updates_(true), map_stamp_(0), map_ingest_ms_(0), map_preprocess_ms_(0) {}
 
     /**
      * Get the cost w.r.t. the map of a single pose
      * @param pose (x, y, theta) relative to the current pose of the robot
      * @return distance cost if not in collision, negative value if in collision
      */
-    virtual double DistanceCost(const Pose& pose) = 0;
+    virtual real_t DistanceCost(const Pose& pose) = 0;
 
     /**
      * Get the cost w.r.t. the map of a sequence of poses
      * @param poses (x, y, theta) relative to the current pose of the robot
      * @return for each entry, distance cost if not in collision, negative value if in collision
      */
-    virtual std::vector<double> DistanceCost(const std::vector<Pose>& path) {
-        std::vector<double> costs(path.size());
+    virtual std::vector<real_t> DistanceCost(const std::vector<Pose>& path) {
+        std::vector<real_t> costs(path.size());
         std::transform(path.cbegin(), path.cend(), costs.begin(), [this](const Pose& p) { return DistanceCost(p); });
         return costs;
     }
 
-    virtual std::vector<double> DistanceCost(const std::vector<PathPoint>& path) {
-        std::vector<double> costs(path.size());
-        std::transform(path.cbegin(), path.cend(), costs.begin(),
-                       [this](const PathPoint& p) { return DistanceCost(p.pose); });
+    virtual std::vector<real_t> DistanceCost(const Path& path) {
+        std::vector<real_t> costs(path.size());
+        for (size_t i = 0; i < path.size(); ++i) {
+            costs[i] = DistanceCost(path.pose(i));
+        }
         return costs;
     }
 
@@ -47,6 +51,27 @@ class MapCostInterface {
         updated_ = false;
     }
 
+    /**
+     * @return time stamp of the source of the stored map data, seconds
+     */
+    [[nodiscard]] double GetMapStamp() const {
+        return map_stamp_;
+    }
+
+    /**
+     * @return time spent converting the last map message into the core map input, milliseconds
+     */
+    [[nodiscard]] double GetMapIngestTime() const {
+        return map_ingest_ms_;
+    }
+
+    /**
+     * @return time spent building the stored map data from the last map input, milliseconds
+     */
+    [[nodiscard]] double GetMapPreprocessTime() const {
+        return map_preprocess_ms_;
+    }
+
     virtual void StartUpdates() {
         accepting_updates_ = true;
     }
@@ -55,8 +80,11 @@ class MapCostInterface {
     }
 
   protected:
-    bool updated_;            // set true when stored map data is updated
-    bool accepting_updates_;  // only modify stored map data when this is true
+    bool updated_;              // set true when stored map data is updated
+    bool accepting_updates_;    // only modify stored map data when this is true
+    double map_stamp_;          // header stamp of the message the stored map was built from
+    double map_ingest_ms_;      // message conversion time of the stored map
+    double map_preprocess_ms_;  // SetMap time of the stored map
 };
 
 }  // namespace rr
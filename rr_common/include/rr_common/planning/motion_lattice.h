@@ -0,0 +1,120 @@
+/*
+ * MotionLattice:
+ * - BicycleModel rollouts of a single control segment, generated offline for every combination of initial speed,
+ *   initial steering angle and steering target on a grid spanning the filter limits
+ * - each primitive stores the poses relative to its start, and the steering and speed at each point
+ * - stored in a flat binary file that is memory-mapped read-only, so loading costs no parsing or copying
+ * - rolls out control sequences by chaining primitives, each rotated and translated onto the end of the previous
+ *   one, instead of integrating the kinematics
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <rr_common/linear_tracking_filter.hpp>
+#include <string>
+
+#include "bicycle_model.h"
+#include "planner_types.hpp"
+
+namespace rr {
+
+class MotionLattice {
+  public:
+    struct Params {
+        int speed_bins;    // initial speed grid points, spanning the speed filter limits
+        int steer_bins;    // initial steering grid points, spanning the steering filter limits
+        int control_bins;  // steering target grid points, spanning the steering filter limits
+    };
+
+    /**
+     * One point of a primitive, relative to the primitive's start pose
+     */
+    struct PrimitivePoint {
+        float x;
+        float y;
+        float theta;
+        float steer;
+        float speed;
+    };
+
+    /**
+     * Enumerate the primitives and write them to a lattice file
+     * @param path Output file
+     * @param params Grid sizes
+     * @param model_params Vehicle model the primitives are rolled out with
+     * @param steer_params Steering filter; its limits span the steering grids
+     * @param speed_params Speed filter; its limits span the speed grid
+     * @throws std::runtime_error if the file can't be written
+     */
+    static void Generate(const std::string& path, const Params& params, const BicycleModel::Params& model_params,
+                         const LinearTrackingFilter::Params& steer_params,
+                         const LinearTrackingFilter::Params& speed_params);
+
+    /**
+     * Map a lattice file written by Generate()
+     * @param path Lattice file
+     * @param model_params Vehicle model the planner uses; must match the one the lattice was generated with
+     * @param steer_model_ptr Filter tracking the platform's steering angle
+     * @param speed_model_ptr Filter tracking the platform's speed
+     * @throws std::runtime_error if the file is missing, truncated, or generated for a different vehicle model
+     */
+    MotionLattice(const std::string& path, const BicycleModel::Params& model_params,
+                  const std::shared_ptr<rr::LinearTrackingFilter>& steer_model_ptr,
+                  const std::shared_ptr<rr::LinearTrackingFilter>& speed_model_ptr);
+    ~MotionLattice();
+
+    MotionLattice(const MotionLattice&) = delete;
+    MotionLattice& operator=(const MotionLattice&) = delete;
+
+    /**
+     * Roll out a trajectory from the current filter state, like BicycleModel::RollOutPath. Each segment is the
+     * trilinear interpolation of the primitives around its initial speed, initial steering angle and control
+     * @param controls Steering target of each segment
+     * @param rollout Output rollout
+     */
+    void RollOutPath(const Controls<1>& controls, TrajectoryRollout& rollout) const;
+
+    [[nodiscard]] int GetSegmentSize() const;
+    [[nodiscard]] int GetNumPrimitives() const;
+    [[nodiscard]] int GetNumControls() const;
+
+    /**
+     * @return steering target of a steering target grid point
+     */
+    [[nodiscard]] real_t GetControl(int control_bin) const;
+
+    /**
+     * @return grid points nearest to an initial speed and steering angle, clamped to the grids
+     */
+    [[nodiscard]] int NearestSpeedBin(real_t speed) const;
+    [[nodiscard]] int NearestSteerBin(real_t steer) const;
+
+    /**
+     * @return the GetSegmentSize() points of a primitive, excluding its start
+     */
+    [[nodiscard]] const PrimitivePoint* GetPrimitive(int speed_bin, int steer_bin, int control_bin) const;
+
+    /**
+     * @return position of a primitive in the file, in [0, GetNumPrimitives())
+     */
+    [[nodiscard]] int PrimitiveIndex(int speed_bin, int steer_bin, int control_bin) const;
+
+  private:
+    struct FileHeader;
+
+    void* mapping_;
+    size_t mapping_size_;
+    const FileHeader* header_;
+    const PrimitivePoint* points_;
+
+    real_t speed_min_, speed_scale_;  // speed grid index = (speed - speed_min_) * speed_scale_
+    real_t steer_min_, steer_scale_;  // initial steering grid index = (steer - steer_min_) * steer_scale_
+    real_t control_scale_;            // steering target grid index = (target - steer_min_) * control_scale_
+
+    std::shared_ptr<rr::LinearTrackingFilter> steering_model_;
+    std::shared_ptr<rr::LinearTrackingFilter> speed_model_;
+};
+
+}  // namespace rr
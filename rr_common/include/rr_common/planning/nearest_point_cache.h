@@ -6,7 +6,8 @@
 
 #pragma once
 
-#include <sensor_msgs/PointCloud2.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
 
 #include <deque>
 #include <mutex>
@@ -23,22 +24,28 @@ class NearestPointCache : public MapCostInterface {
   public:
     using point_t = pcl::PointXYZ;
 
+    struct Params {
+        Rectangle map_limits;          // cache bounds. Set this so that it is not possible for paths to leave this box
+        Rectangle hitbox;              // hitbox of the robot
+        double cache_resolution;       // side length of a cache cell
+        double distance_decay_factor;  // map cost is exp(-distance_decay_factor * dist)
+    };
+
     /**
      * Constructor
-     * @param hitbox Hitbox of the robot
-     * @param map_size Map size limits for cached distances. Set this so that it is not possible for paths to leave this
-     * box.
+     * @param params Cache layout and robot hitbox
      */
-    explicit NearestPointCache(ros::NodeHandle nh);
+    explicit NearestPointCache(const Params& params);
 
-    double DistanceCost(const Pose& pose) override;
+    real_t DistanceCost(const Pose& pose) override;
 
-  private:
     /**
      * Given a map, cache the nearest neighbors. Fill the cache outwards from locations containing obstacle points.
-     * @param map Point cloud map representation
+     * @param cloud Point cloud map representation, in the robot frame
      */
-    void SetMapMessage(const sensor_msgs::PointCloud2ConstPtr& cloud);
+    void SetMap(pcl::PointCloud<point_t> cloud);
+
+  private:
 
     /*
      * Caching system: map from discretized x, y location to its nearest neighbor in the map/obstacle point cloud
@@ -90,7 +97,6 @@ class NearestPointCache : public MapCostInterface {
     rr::Rectangle hitbox_;
     double hitbox_corner_dist_;
 
-    ros::Subscriber map_sub_;
     std::mutex mutex_;
 };
 
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <ros/ros.h>
+
+#include <rr_common/obstacle_transport.hpp>
+
+#include "nearest_point_cache.h"
+
+namespace rr {
+
+/**
+ * ROS adapter for NearestPointCache: subscribes to an obstacle point cloud in the robot frame
+ */
+class NearestPointCacheRos : public NearestPointCache {
+  public:
+    explicit NearestPointCacheRos(ros::NodeHandle nh);
+
+  private:
+    void SetMapMessage(const ObstaclePoints& points);
+
+    ObstacleSubscriber map_sub_;
+};
+
+}  // namespace rr
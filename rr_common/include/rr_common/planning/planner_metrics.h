@@ -0,0 +1,111 @@
+/*
+ * Planner instrumentation:
+ * - LatencyHistogram counts durations into log-spaced buckets with relaxed atomics, so any thread can record
+ *   and any thread can read without locks
+ * - PlannerMetrics holds one histogram per planning phase plus the cost evaluation throughput
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace rr {
+
+class LatencyHistogram {
+  public:
+    static constexpr double kMinMs = 0.001;         // upper bound of the first bucket
+    static constexpr int kBucketsPerOctave = 4;     // percentiles are accurate to within 2^(1/4), about 19%
+    static constexpr int kNumBuckets = 4 * 24 + 1;  // up to about 17 seconds
+
+    LatencyHistogram();
+
+    void Add(double ms);
+
+    [[nodiscard]] uint64_t Count() const;
+    [[nodiscard]] double Mean() const;
+    [[nodiscard]] double Max() const;
+
+    /**
+     * @param p Percentile in [0, 100]
+     * @return upper bound of the bucket holding the p-th percentile sample, or 0 if empty
+     */
+    [[nodiscard]] double Percentile(double p) const;
+
+  private:
+    static double BucketUpperBound(int bucket);
+
+    std::array<std::atomic<uint64_t>, kNumBuckets> buckets_;
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_ns_;
+    std::atomic<uint64_t> max_ns_;
+};
+
+enum class PlannerPhase {
+    MapIngest,      // map message to core map input: conversion and transform lookup
+    MapPreprocess,  // building the map cost structure from the input
+    Optimize,       // optimizer wall time
+    Rollout,        // vehicle model rollouts, summed over all cost evaluations of a plan
+    CostLookup,     // map cost lookups and scoring, summed over all cost evaluations of a plan
+    Publish,        // commands and visualization
+    Total,          // whole planning cycle, excluding map ingest and preprocessing
+    Count
+};
+
+const char* PlannerPhaseName(PlannerPhase phase);
+
+/**
+ * Per-plan accumulators for work spread across optimizer threads
+ */
+struct CostFunctionTiming {
+    std::atomic<uint64_t> evaluations{ 0 };
+    std::atomic<uint64_t> rollout_ns{ 0 };
+    std::atomic<uint64_t> cost_lookup_ns{ 0 };
+};
+
+class PlannerMetrics {
+  public:
+    PlannerMetrics();
+
+    void AddPhase(PlannerPhase phase, double ms) {
+        phases_[static_cast<size_t>(phase)].Add(ms);
+    }
+
+    [[nodiscard]] const LatencyHistogram& Phase(PlannerPhase phase) const {
+        return phases_[static_cast<size_t>(phase)];
+    }
+
+    /**
+     * Record the optimizer time and evaluation breakdown of one plan
+     */
+    void AddPlan(double optimize_ms, const CostFunctionTiming& timing);
+
+    [[nodiscard]] uint64_t Plans() const {
+        return plans_;
+    }
+    [[nodiscard]] uint64_t CostEvaluations() const {
+        return evaluations_;
+    }
+
+    /**
+     * @return cost evaluations per second of optimizer wall time
+     */
+    [[nodiscard]] double EvaluationsPerSecond() const;
+
+  private:
+    std::array<LatencyHistogram, static_cast<size_t>(PlannerPhase::Count)> phases_;
+    std::atomic<uint64_t> plans_;
+    std::atomic<uint64_t> evaluations_;
+    std::atomic<uint64_t> optimize_ns_;
+};
+
+/**
+ * Milliseconds since start on the steady clock
+ */
+inline double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace rr
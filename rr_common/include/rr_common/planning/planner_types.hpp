@@ -1,26 +1,36 @@
 #pragma once
 
-#include <pcl/point_cloud.h>
-#include <pcl/point_types.h>
-
 #include <eigen3/Eigen/Core>
+#include <cstdint>
+#include <functional>
+#include <ostream>
 #include <vector>
 
 namespace rr {
 
+/**
+ * Scalar type of the planning core. Building with RR_PLANNER_SINGLE_PRECISION (cmake option
+ * PLANNER_SINGLE_PRECISION) switches poses, controls, rollouts and costs to float32.
+ */
+#ifdef RR_PLANNER_SINGLE_PRECISION
+using real_t = float;
+#else
+using real_t = double;
+#endif
+
 /**
  * Pose: 2D state vector
  */
 struct Pose {
-    double x;
-    double y;
-    double theta;
+    real_t x;
+    real_t y;
+    real_t theta;
 
-    Pose(double x, double y, double theta) : x(x), y(y), theta(theta) {}
+    Pose(real_t x, real_t y, real_t theta) : x(x), y(y), theta(theta) {}
     Pose() : x(0), y(0), theta(0) {}
 };
 
-std::ostream& operator<<(std::ostream& out, const Pose& p) {
+inline std::ostream& operator<<(std::ostream& out, const Pose& p) {
     return out << "Pose(x=" << p.x << ", y=" << p.y << ", theta=" << p.theta << ")";
 }
 
@@ -29,38 +39,89 @@ std::ostream& operator<<(std::ostream& out, const Pose& p) {
  */
 struct PathPoint {
     Pose pose;
-    double steer;
-    double speed;
-    double time;
+    real_t steer;
+    real_t speed;
+    real_t time;
 };
 
-std::ostream& operator<<(std::ostream& out, const PathPoint& p) {
+inline std::ostream& operator<<(std::ostream& out, const PathPoint& p) {
     return out << "PathPoint(t=" << p.time << ", pose=" << p.pose << ", steer=" << p.steer << ", speed=" << p.speed
                << ")";
 }
 
+/**
+ * Path: sequence of path points stored as a structure of arrays, so that per-field loops over a rollout
+ * (cost lookups, speed limiting) read contiguous memory
+ */
+struct Path {
+    std::vector<real_t> x;
+    std::vector<real_t> y;
+    std::vector<real_t> theta;
+    std::vector<real_t> steer;
+    std::vector<real_t> speed;
+    std::vector<real_t> time;
+
+    [[nodiscard]] inline size_t size() const {
+        return x.size();
+    }
+
+    [[nodiscard]] inline bool empty() const {
+        return x.empty();
+    }
+
+    inline void resize(size_t n) {
+        x.resize(n);
+        y.resize(n);
+        theta.resize(n);
+        steer.resize(n);
+        speed.resize(n);
+        time.resize(n);
+    }
+
+    [[nodiscard]] inline Pose pose(size_t i) const {
+        return Pose(x[i], y[i], theta[i]);
+    }
+
+    [[nodiscard]] inline PathPoint operator[](size_t i) const {
+        return PathPoint{ pose(i), steer[i], speed[i], time[i] };
+    }
+};
+
+/**
+ * OccupancyGrid: ROS-independent copy of a nav_msgs/OccupancyGrid. Cell (mx, my) is data[my * width + mx], and
+ * cell (0, 0) sits at (origin_x, origin_y) in the grid frame
+ */
+struct OccupancyGrid {
+    std::vector<int8_t> data;
+    unsigned int width;
+    unsigned int height;
+    double resolution;
+    double origin_x;
+    double origin_y;
+};
+
 template <int R, int C>
-using Matrix = Eigen::Matrix<double, R, C>;
+using Matrix = Eigen::Matrix<real_t, R, C>;
 
 template <int N>
-using Vector = Eigen::Matrix<double, N, 1>;
+using Vector = Eigen::Matrix<real_t, N, 1>;
 
 template <int ctrl_dim>
-using Controls = Eigen::Matrix<double, ctrl_dim, -1, Eigen::RowMajor, ctrl_dim, 10>;
+using Controls = Eigen::Matrix<real_t, ctrl_dim, -1, Eigen::RowMajor, ctrl_dim, 10>;
 
 struct TrajectoryRollout {
-    std::vector<PathPoint> path;
-    double apply_speed;
-    double apply_steering;
+    Path path;
+    real_t apply_speed;
+    real_t apply_steering;
 };
 
 struct TrajectoryPlan {
     TrajectoryRollout rollout;
-    double cost;  // result of applying cost function
+    real_t cost;  // result of applying cost function
     bool has_collision;
 };
 
 template <int ctrl_dim>
-using CostFunction = std::function<double(const Controls<ctrl_dim>&)>;
+using CostFunction = std::function<real_t(const Controls<ctrl_dim>&)>;
 
 }  // namespace rr
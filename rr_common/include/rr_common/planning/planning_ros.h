@@ -0,0 +1,70 @@
+/*
+ * ROS glue for the planning core: loads parameter structs from the parameter server and converts messages into
+ * the core's plain types. The core itself (bicycle model, map costs, optimizers) does not depend on ROS.
+ */
+
+#pragma once
+
+#include <nav_msgs/OccupancyGrid.h>
+#include <ros/node_handle.h>
+#include <tf/transform_datatypes.h>
+
+#include <rr_common/linear_tracking_filter.hpp>
+
+#include "annealing_optimizer.h"
+#include "bicycle_model.h"
+#include "coarse_to_fine.h"
+#include "distance_map.h"
+#include "hill_climb_optimizer.h"
+#include "inflation_map.h"
+#include "lattice_search_optimizer.h"
+#include "nearest_point_cache.h"
+#include "planner_types.hpp"
+#include "rectangle.hpp"
+#include "trajectory_cost.h"
+
+namespace rr {
+
+void LoadParams(const ros::NodeHandle& nh, Rectangle& params);
+void LoadParams(const ros::NodeHandle& nh, LinearTrackingFilter::Params& params);
+void LoadParams(const ros::NodeHandle& nh, BicycleModel::Params& params);
+void LoadParams(const ros::NodeHandle& nh, DistanceMap::Params& params);
+void LoadParams(const ros::NodeHandle& nh, InflationMap::Params& params);
+void LoadParams(const ros::NodeHandle& nh, NearestPointCache::Params& params);
+void LoadParams(const ros::NodeHandle& nh, CostWeights& params);
+void LoadParams(const ros::NodeHandle& nh, CoarseToFinePlanner::Params& params);
+void LoadParams(const ros::NodeHandle& nh, LatticeSearchOptimizer::Params& params);
+
+/**
+ * Default-construct a parameter struct and load it, for use in constructor initializer lists
+ * @param nh NodeHandle in the namespace holding the parameters
+ * @return loaded parameters
+ */
+template <typename Params>
+Params LoadParams(const ros::NodeHandle& nh) {
+    Params params{};
+    LoadParams(nh, params);
+    return params;
+}
+
+/*
+ * Optimizer parameters are nested in class templates, so ctrl_dim can't be deduced; call these as
+ * LoadParams<ctrl_dim>(nh, params)
+ */
+template <int ctrl_dim>
+void LoadParams(const ros::NodeHandle& nh, typename AnnealingOptimizer<ctrl_dim>::Params& params);
+
+template <int ctrl_dim>
+void LoadParams(const ros::NodeHandle& nh, typename HillClimbOptimizer<ctrl_dim>::Params& params);
+
+/**
+ * Copy a nav_msgs/OccupancyGrid into the core occupancy grid type
+ */
+OccupancyGrid FromOccupancyGridMsg(const nav_msgs::OccupancyGrid& msg);
+
+/**
+ * Flatten a tf transform into a 2D pose (x, y, yaw)
+ */
+Pose FromTransform(const tf::Transform& transform);
+
+}  // namespace rr
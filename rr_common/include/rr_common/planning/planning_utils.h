@@ -8,37 +8,45 @@
 
 namespace rr {
 
+/**
+ * Perturb controls with gaussian noise, drawing from the caller's generator so that threads can keep their own
+ */
 template <int ctrl_dim>
 inline Controls<ctrl_dim> controls_neighbor(const Controls<ctrl_dim>& ctrl, const Matrix<ctrl_dim, 2>& limits,
-                                            const Vector<ctrl_dim>& stddevs) {
-    static std::mt19937 rand_gen(1234567);  // constant value allows for repeatable testing if desired
-    static std::normal_distribution<double> normal_pdf(0, 1);
+                                            const Vector<ctrl_dim>& stddevs, std::mt19937& rand_gen) {
+    std::normal_distribution<real_t> normal_pdf(0, 1);
 
     Controls<ctrl_dim> neighbor(ctrl_dim, ctrl.cols());
     for (long dim = 0; dim < ctrl.rows(); ++dim) {
         for (long i = 0; i < ctrl.cols(); ++i) {
-            double raw = ctrl(dim, i) + normal_pdf(rand_gen) * stddevs(dim);
+            real_t raw = ctrl(dim, i) + normal_pdf(rand_gen) * stddevs(dim);
             neighbor(dim, i) = std::clamp(raw, limits(dim, 0), limits(dim, 1));
         }
     }
     return neighbor;
 }
 
+/**
+ * Random controls around the middle of the limits
+ */
 template <int ctrl_dim>
 inline Controls<ctrl_dim> init_controls(int n_control_points, const Matrix<ctrl_dim, 2>& limits,
-                                        const Vector<ctrl_dim>& stddevs) {
+                                        const Vector<ctrl_dim>& stddevs, std::mt19937& rand_gen) {
     Controls<ctrl_dim> ctrl(ctrl_dim, n_control_points);
-    auto mid = (limits.col(1) + limits.col(0)) * 0.5;
+    auto mid = (limits.col(1) + limits.col(0)) * real_t(0.5);
     for (int dim = 0; dim < ctrl_dim; ++dim) {
         ctrl.row(dim).setConstant(mid(dim));
     }
-    return controls_neighbor(ctrl, limits, stddevs);
+    return controls_neighbor(ctrl, limits, stddevs, rand_gen);
 }
 
+/**
+ * Controls drawn uniformly within the limits
+ */
 template <int ctrl_dim>
-inline Controls<ctrl_dim> init_controls(int n_control_points, const Matrix<ctrl_dim, 2>& limits) {
-    static std::mt19937 rand_gen(1234567);  // constant value allows for repeatable testing if desired
-    static std::uniform_real_distribution<double> uniform_01(0, 1);
+inline Controls<ctrl_dim> init_controls(int n_control_points, const Matrix<ctrl_dim, 2>& limits,
+                                        std::mt19937& rand_gen) {
+    std::uniform_real_distribution<real_t> uniform_01(0, 1);
 
     Controls<ctrl_dim> ctrl(ctrl_dim, n_control_points);
     for (long dim = 0; dim < ctrl.rows(); ++dim) {
@@ -1,7 +1,9 @@
 #pragma once
 
-#include <parameter_assertions/assertions.h>
-#include <ros/node_handle.h>
+#include <cmath>
+#include <utility>
+
+#include "planner_types.hpp"
 
 namespace rr {
 
@@ -23,16 +25,6 @@ struct Rectangle {
     Rectangle() = default;
     Rectangle(const Rectangle& other) = default;
 
-    explicit Rectangle(const ros::NodeHandle& nh) {
-        assertions::getParam(nh, "min_x", min_x);
-        assertions::getParam(nh, "max_x", max_x);
-        assertions::getParam(nh, "min_y", min_y);
-        assertions::getParam(nh, "max_y", max_y);
-        assertions::param(nh, "origin_x", origin.x, 0.0);
-        assertions::param(nh, "origin_y", origin.y, 0.0);
-        assertions::param(nh, "origin_theta", origin.theta, 0.0);
-    }
-
     [[nodiscard]] inline bool PointInside(double x, double y) const {
         double cos_th = std::cos(origin.theta);
         double sin_th = std::sin(origin.theta);
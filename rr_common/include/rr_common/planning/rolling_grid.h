@@ -0,0 +1,107 @@
+/*
+ * RollingGrid:
+ * - fixed-size 2D grid of hit counts and last-seen times around the vehicle, for accumulating obstacle points
+ * - cells are aligned to a frame that doesn't rotate with the vehicle; the window follows the vehicle by moving its
+ *   origin a whole number of cells, and storage is a ring buffer so only the rows and columns scrolling in are cleared
+ * - inserting a point is a single cell update, with no sorting or allocation, and memory never grows
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace rr {
+
+class RollingGrid {
+  public:
+    struct Params {
+        double resolution;  // cell side, meters
+        int size;           // cells per side of the square window
+    };
+
+    /**
+     * Points (x, y) with a * x + b * y > c
+     */
+    struct HalfPlane {
+        double a;
+        double b;
+        double c;
+    };
+
+    explicit RollingGrid(const Params& params);
+
+    /**
+     * Move the window to center on a position, forgetting the cells that leave it
+     */
+    void Recenter(double x, double y);
+
+    /**
+     * Count a hit in the cell containing a position. Positions outside the window are ignored
+     */
+    void AddHit(double x, double y, double time);
+
+    /**
+     * Empty every cell
+     */
+    void Clear();
+
+    /**
+     * Empty the cells last seen before a time
+     */
+    void Expire(double min_time);
+
+    /**
+     * Empty the cells whose centers are inside a convex polygon, given as the intersection of half-planes. Each row's
+     * inside cells are found from the half-plane bounds directly, so cells outside the polygon aren't visited
+     */
+    void ClearInside(const std::vector<HalfPlane>& polygon);
+
+    /**
+     * Call fn(x, y, hits, last_seen) for the center of every cell with at least min_hits hits
+     */
+    template <typename Fn>
+    void ForEachOccupied(uint16_t min_hits, Fn fn) const;
+
+    [[nodiscard]] double GetResolution() const {
+        return resolution_;
+    }
+    [[nodiscard]] int GetSize() const {
+        return size_;
+    }
+
+  private:
+    /**
+     * @return storage index of a cell, from its column and row in the unbounded grid
+     */
+    [[nodiscard]] size_t Index(int64_t col, int64_t row) const {
+        const int64_t c = ((col % size_) + size_) % size_;
+        const int64_t r = ((row % size_) + size_) % size_;
+        return static_cast<size_t>(r * size_ + c);
+    }
+
+    double resolution_;
+    int size_;
+    int64_t origin_col_;  // column and row of the window's lower left cell in the unbounded grid
+    int64_t origin_row_;
+
+    std::vector<uint16_t> hits_;     // saturating; 0 marks an empty cell
+    std::vector<double> last_seen_;  // time of each cell's latest hit
+};
+
+template <typename Fn>
+void RollingGrid::ForEachOccupied(uint16_t min_hits, Fn fn) const {
+    min_hits = std::max<uint16_t>(min_hits, 1);
+    for (int64_t row = origin_row_; row < origin_row_ + size_; ++row) {
+        for (int64_t col = origin_col_; col < origin_col_ + size_; ++col) {
+            const size_t i = Index(col, row);
+            if (hits_[i] >= min_hits) {
+                fn((col + 0.5) * resolution_, (row + 0.5) * resolution_, hits_[i], last_seen_[i]);
+            }
+        }
+    }
+}
+
+}  // namespace rr
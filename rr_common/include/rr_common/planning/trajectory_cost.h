@@ -0,0 +1,54 @@
+#pragma once
+
+#include "bicycle_model.h"
+#include "map_cost_interface.h"
+#include "motion_lattice.h"
+#include "planner_metrics.h"
+#include "planner_types.hpp"
+
+namespace rr {
+
+/**
+ * Weights of the trajectory cost terms. Per path point, the cost is
+ * k_map_cost * map_cost + k_speed * (max_speed - speed)^2 + k_steering * |steer| + k_angle * |theta|,
+ * and the first point in collision adds collision_penalty for every remaining point
+ */
+struct CostWeights {
+    double k_map_cost;
+    double k_speed;
+    double k_steering;
+    double k_angle;
+    double collision_penalty;
+};
+
+/**
+ * Each path point weighs this much more than the next in TrajectoryCost
+ */
+constexpr real_t kTrajectoryCostDiscount = 1.01;
+
+/**
+ * Score a rolled-out trajectory against its per-point map costs
+ * @param path Rolled-out path
+ * @param map_costs Map cost of each path point, negative if in collision
+ * @param weights Cost term weights
+ * @param max_speed Straight-line desired speed
+ * @return discounted total cost
+ */
+real_t TrajectoryCost(const Path& path, const std::vector<real_t>& map_costs, const CostWeights& weights,
+                      real_t max_speed);
+
+/**
+ * Build the planner's cost function: roll out the controls with the vehicle model and score them on the map.
+ * The returned function refers to model, map_cost and timing, which must outlive it
+ * @param timing If given, evaluations and the time spent rolling out and scoring are accumulated here
+ */
+CostFunction<1> MakeCostFunction(const BicycleModel& model, MapCostInterface& map_cost, const CostWeights& weights,
+                                 real_t max_speed, CostFunctionTiming* timing = nullptr);
+
+/**
+ * Same as above, rolling out candidates from the lattice's precomputed primitives instead of integrating them
+ */
+CostFunction<1> MakeCostFunction(const MotionLattice& lattice, MapCostInterface& map_cost, const CostWeights& weights,
+                                 real_t max_speed, CostFunctionTiming* timing = nullptr);
+
+}  // namespace rr
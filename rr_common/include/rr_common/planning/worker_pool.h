@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rr {
+
+/**
+ * Fixed set of threads for running many short parallel loops without creating threads for each one
+ */
+class WorkerPool {
+  public:
+    /**
+     * @param num_threads Threads to start in addition to the caller of ParallelFor
+     */
+    explicit WorkerPool(int num_threads);
+
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * Call fn(i) for every i in [0, n), spread over the pool and the calling thread. Returns once all calls finish.
+     * Not reentrant: only one thread may call ParallelFor at a time
+     */
+    void ParallelFor(int n, const std::function<void(int)>& fn);
+
+  private:
+    void WorkerLoop();
+    void RunTasks();
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+
+    const std::function<void(int)>* task_;
+    int task_count_;
+    std::atomic<int> next_index_;
+    int busy_workers_;
+    unsigned long generation_;
+    bool stop_;
+};
+
+}  // namespace rr
@@ -0,0 +1,55 @@
+/*
+ * YAML equivalents of the LoadParams overloads in planning_ros, reading the same keys from a planner config file
+ * - for the offline tools (planner_replay, motion_lattice_generator), which run without a parameter server
+ * - header-only, so that only the tools link against yaml-cpp and the planning core doesn't
+ */
+
+#pragma once
+
+#include <yaml-cpp/yaml.h>
+
+#include <stdexcept>
+#include <string>
+
+#include <rr_common/linear_tracking_filter.hpp>
+
+#include "bicycle_model.h"
+#include "rectangle.hpp"
+
+namespace rr {
+
+/**
+ * Read a required parameter
+ * @throws std::runtime_error if the key is missing
+ */
+template <typename T>
+T YamlParam(const YAML::Node& node, const std::string& key) {
+    if (!node[key]) {
+        throw std::runtime_error("missing planner parameter \"" + key + "\"");
+    }
+    return node[key].as<T>();
+}
+
+inline Rectangle LoadRectangle(const YAML::Node& node) {
+    Rectangle rect(YamlParam<double>(node, "min_x"), YamlParam<double>(node, "max_x"), YamlParam<double>(node, "min_y"),
+                   YamlParam<double>(node, "max_y"));
+    rect.origin = Pose(node["origin_x"].as<double>(0.0), node["origin_y"].as<double>(0.0),
+                       node["origin_theta"].as<double>(0.0));
+    return rect;
+}
+
+inline LinearTrackingFilter::Params LoadFilter(const YAML::Node& node) {
+    return { YamlParam<double>(node, "init_val"), YamlParam<double>(node, "val_min"),
+             YamlParam<double>(node, "val_max"), YamlParam<double>(node, "rate_min"),
+             YamlParam<double>(node, "rate_max") };
+}
+
+/**
+ * The required bicycle model parameters; the optional ones keep their defaults
+ */
+inline BicycleModel::Params LoadBicycleModel(const YAML::Node& node) {
+    return { YamlParam<double>(node, "wheel_base"), YamlParam<double>(node, "lateral_accel"),
+             YamlParam<int>(node, "segment_size"), YamlParam<double>(node, "dt") };
+}
+
+}  // namespace rr
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <sensor_msgs/PointCloud2.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+namespace rr {
+
+/*
+ * PointCloudXYView:
+ * - read-only view of the x and y fields of a sensor_msgs::PointCloud2, for consumers that only need 2D points
+ * - reads the message's buffer in place, at the fields' offsets and the cloud's point and row strides; nothing is
+ *   copied or converted into a pcl cloud first
+ * - the message must outlive the view
+ */
+class PointCloudXYView {
+  public:
+    struct Point {
+        float x;
+        float y;
+    };
+
+    class Iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Point;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Point*;
+        using reference = Point;
+
+        Iterator(const PointCloudXYView* view, const uint8_t* row) : view_(view), row_(row), col_(0) {}
+
+        Point operator*() const {
+            return view_->Read(row_ + col_ * view_->point_step_);
+        }
+        Iterator& operator++() {
+            if (++col_ == view_->width_) {
+                col_ = 0;
+                row_ += view_->row_step_;
+            }
+            return *this;
+        }
+        bool operator==(const Iterator& other) const {
+            return row_ == other.row_ && col_ == other.col_;
+        }
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+      private:
+        const PointCloudXYView* view_;
+        const uint8_t* row_;
+        size_t col_;
+    };
+
+    /**
+     * A cloud without FLOAT32 x and y fields in this host's byte order, or whose buffer is too short for its
+     * dimensions, gives an empty, invalid view
+     */
+    explicit PointCloudXYView(const sensor_msgs::PointCloud2& msg)
+          : data_(msg.data.data())
+          , width_(msg.width)
+          , height_(msg.height)
+          , size_(0)
+          , point_step_(msg.point_step)
+          , row_step_(msg.row_step)
+          , x_offset_(0)
+          , y_offset_(0)
+          , valid_(false) {
+        bool has_x = false;
+        bool has_y = false;
+        for (const auto& field : msg.fields) {
+            const bool usable = field.datatype == sensor_msgs::PointField::FLOAT32 &&
+                                field.offset + sizeof(float) <= msg.point_step;
+            if (field.name == "x" && usable) {
+                x_offset_ = field.offset;
+                has_x = true;
+            } else if (field.name == "y" && usable) {
+                y_offset_ = field.offset;
+                has_y = true;
+            }
+        }
+
+        // some publishers leave row_step unset on unorganized clouds, where it doesn't matter
+        const size_t row_size = width_ * point_step_;
+        if (height_ <= 1) {
+            row_step_ = row_size;
+        }
+        valid_ = has_x && has_y && msg.is_bigendian == kHostBigEndian && row_step_ >= row_size &&
+                 msg.data.size() >= height_ * row_step_;
+        if (valid_) {
+            size_ = size_t(msg.width) * msg.height;
+        }
+    }
+
+    [[nodiscard]] bool valid() const {
+        return valid_;
+    }
+    [[nodiscard]] size_t size() const {
+        return size_;
+    }
+    [[nodiscard]] bool empty() const {
+        return size_ == 0;
+    }
+
+    [[nodiscard]] Point operator[](size_t i) const {
+        return Read(data_ + (i / width_) * row_step_ + (i % width_) * point_step_);
+    }
+
+    /**
+     * Iteration steps through the buffer by the point and row strides, without the division of operator[]
+     */
+    [[nodiscard]] Iterator begin() const {
+        return Iterator(this, data_);
+    }
+    [[nodiscard]] Iterator end() const {
+        return Iterator(this, size_ == 0 ? data_ : data_ + height_ * row_step_);
+    }
+
+  private:
+    [[nodiscard]] Point Read(const uint8_t* point) const {
+        // fields needn't be aligned
+        Point p{};
+        std::memcpy(&p.x, point + x_offset_, sizeof(float));
+        std::memcpy(&p.y, point + y_offset_, sizeof(float));
+        return p;
+    }
+
+    static constexpr bool kHostBigEndian = __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__;
+
+    const uint8_t* data_;
+    size_t width_;
+    size_t height_;
+    size_t size_;
+    size_t point_step_;
+    size_t row_step_;
+    size_t x_offset_;
+    size_t y_offset_;
+    bool valid_;
+};
+
+}  // namespace rr
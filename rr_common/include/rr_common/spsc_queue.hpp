@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace rr {
+
+/*
+ * SPSCQueue:
+ * - bounded lock-free queue between exactly one producer thread and one consumer thread
+ * - neither side ever blocks or allocates after construction; a push to a full queue fails instead of waiting
+ * - the indices live on separate cache lines so the two threads don't contend on them
+ */
+template <typename T>
+class SPSCQueue {
+  public:
+    /**
+     * @param capacity Most items held at once, rounded up to a power of two
+     */
+    explicit SPSCQueue(size_t capacity) : head_(0), tail_(0) {
+        size_t size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+        buffer_.resize(size);
+        mask_ = size - 1;
+    }
+
+    /**
+     * Producer only
+     * @return false if the queue is full, and the item wasn't added
+     */
+    bool TryPush(const T& item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        buffer_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer only
+     * @return false if the queue is empty
+     */
+    bool TryPop(T& item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = buffer_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+  private:
+    std::vector<T> buffer_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_;  // next item to pop, written by the consumer
+    alignas(64) std::atomic<size_t> tail_;  // next slot to push, written by the producer
+};
+
+}  // namespace rr
@@ -7,14 +7,10 @@ void pidCallback(std_msgs::Float64 pidSpeed) {
     outputSpeed.speed = newSpeed;
     speed_pub.publish(outputSpeed);
 }
-void mapCallback(const sensor_msgs::PointCloud2ConstPtr& map) {
-    pcl::PCLPointCloud2 pcl_pc2;
-    pcl_conversions::toPCL(*map, pcl_pc2);
-    pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>);
-    pcl::fromPCLPointCloud2(pcl_pc2, *cloud);
+void mapCallback(const rr::ObstaclePoints& cloud) {
     rr_msgs::speedPtr speedMSG(new rr_msgs::speed);
     rr_msgs::steeringPtr steerMSG(new rr_msgs::steering);
-    if (cloud->empty()) {
+    if (cloud.empty()) {
         ROS_WARN("environment map pointcloud is empty");
         speedMSG->speed = 0;
         steerMSG->angle = 0;
@@ -22,33 +18,20 @@ void mapCallback(const sensor_msgs::PointCloud2ConstPtr& map) {
         steer_pub.publish(steerMSG);
         return;
     }
-    pcl::PointCloud<pcl::PointXYZ>::Ptr cloud_filtered(new pcl::PointCloud<pcl::PointXYZ>);
-
-    // Bounds the x-dimension
-    pcl::PassThrough<pcl::PointXYZ> passLimitX;
-    passLimitX.setInputCloud(cloud);
-    passLimitX.setFilterFieldName("x");
-    passLimitX.setFilterLimits(MIN_FRONT_VISION, MAX_FRONT_VISION);
-    passLimitX.filter(*cloud_filtered);
-
-    // Bounds the y-dimension
-    pcl::PassThrough<pcl::PointXYZ> passLimitY;
-    passLimitY.setInputCloud(cloud_filtered);
-    passLimitY.setFilterFieldName("y");
-    passLimitY.setFilterLimits(MIN_SIDE_VISION, MAX_SIDE_VISION);
-    passLimitY.filter(*cloud_filtered);
-
-    // Finds closest point
+
+    // Finds closest point inside the x and y bounds, reading the message in place
     float minX = INT_MAX;
-    for (pcl::PointXYZ point : cloud_filtered->points) {
-        if (point.x < minX) {
-            minX = point.x;
+    size_t in_bounds = 0;
+    cloud.ForEach([&](float x, float y) {
+        if (x >= MIN_FRONT_VISION && x <= MAX_FRONT_VISION && y >= MIN_SIDE_VISION && y <= MAX_SIDE_VISION) {
+            minX = std::min(minX, x);
+            in_bounds++;
         }
-    }
+    });
 
-    if (cloud_filtered->points.size() != 0) {  // computes the average distance away
-                                               //        avgX = avgX / cloud_filtered->points.size();
-                                               //        ROS_INFO_STREAM("Average X = " << avgX);
+    if (in_bounds != 0) {  // computes the average distance away
+                           //        avgX = avgX / cloud_filtered->points.size();
+                           //        ROS_INFO_STREAM("Average X = " << avgX);
         ROS_INFO_STREAM("Min X = " << minX);
 
     } else {  // Nothing in bounding box
@@ -115,7 +98,8 @@ int main(int argc, char** argv) {
 
     auto pid_sub = nh.subscribe(topic_from_controller, 1, pidCallback);
 
-    auto map_sub = nh.subscribe(obstacleCloudTopic, 1, mapCallback);
+    rr::ObstacleSubscriber map_sub;
+    map_sub.Subscribe(nh, obstacleCloudTopic, mapCallback);
     steer_pub = nh.advertise<rr_msgs::steering>("/steering", 1);
 
     ROS_INFO("follower initialized");
@@ -3,15 +3,14 @@
 
 #include <geometry_msgs/Point32.h>
 #include <geometry_msgs/PolygonStamped.h>
-#include <pcl/PCLPointCloud2.h>
-#include <pcl/filters/passthrough.h>
-#include <pcl/point_cloud.h>
-#include <pcl_conversions/pcl_conversions.h>
 #include <ros/ros.h>
 #include <rr_msgs/speed.h>
 #include <rr_msgs/steering.h>
 #include <std_msgs/Float64.h>
 
+#include <algorithm>
+#include <climits>
+#include <rr_common/obstacle_transport.hpp>
 #include <string>
 
 #include "flann/flann.hpp"
@@ -4,13 +4,12 @@
 #include <pcl/filters/voxel_grid.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
-#include <pcl_conversions/pcl_conversions.h>
 #include <pluginlib/class_list_macros.h>
 #include <ros/ros.h>
 #include <rr_common/CameraGeometry.h>
 #include <sensor_msgs/Image.h>
-#include <sensor_msgs/PointCloud2.h>
 
+#include <rr_common/obstacle_transport.hpp>
 #include <thread>
 
 using PointT = pcl::PointXYZ;
@@ -18,7 +17,7 @@ using PointT = pcl::PointXYZ;
 class PointCloudProjector : public nodelet::Nodelet {
   private:
     rr::CameraGeometry cam_geom_;
-    ros::Publisher pointcloud_pub_;
+    rr::ObstaclePublisher pointcloud_pub_;
     image_transport::Subscriber detection_image_sub_;
     pcl::PointCloud<PointT>::Ptr cloud_unfiltered_;
     pcl::VoxelGrid<PointT> grid_filter_;
@@ -59,11 +58,10 @@ class PointCloudProjector : public nodelet::Nodelet {
         grid_filter_.setInputCloud(cloud_unfiltered_);
         grid_filter_.filter(filtered_cloud);
 
-        sensor_msgs::PointCloud2Ptr out(new sensor_msgs::PointCloud2);
-        pcl::toROSMsg(filtered_cloud, *out);
-        out->header.frame_id = "base_footprint";
-        out->header.stamp = msg->header.stamp;
-        pointcloud_pub_.publish(out);
+        std_msgs::Header header;
+        header.frame_id = "base_footprint";
+        header.stamp = msg->header.stamp;
+        pointcloud_pub_.Publish(header, filtered_cloud);
     }
 
     void onInit() override {
@@ -101,7 +99,7 @@ class PointCloudProjector : public nodelet::Nodelet {
 
         detection_image_sub_ = image_transport.subscribe(image_topic_in, 1, &PointCloudProjector::ImageCallback, this);
 
-        pointcloud_pub_ = node_handle.advertise<sensor_msgs::PointCloud2>(pointcloud_topic_out, 1);
+        pointcloud_pub_ = rr::ObstaclePublisher(node_handle, pointcloud_topic_out);
 
         cloud_unfiltered_.reset(new pcl::PointCloud<PointT>);
         grid_filter_.setLeafSize(0.05f, 0.05f, 0.05f);
@@ -1,173 +1,251 @@
-#include <pcl/filters/voxel_grid.h>
+#include <nodelet/nodelet.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
-#include <pcl_conversions/pcl_conversions.h>
-#include <pcl_ros/transforms.h>
+#include <pluginlib/class_list_macros.h>
 #include <ros/ros.h>
 #include <rr_common/CameraGeometry.h>
 #include <rr_common/RelativePoseHistoryClient.h>
-#include <sensor_msgs/PointCloud2.h>
+#include <rr_common/planning/rolling_grid.h>
 
-#include <deque>
+#include <atomic>
+#include <cmath>
+#include <memory>
 #include <rr_common/angle_utils.hpp>
+#include <rr_common/obstacle_transport.hpp>
+#include <thread>
 
 // types
 using PointCloud = pcl::PointCloud<pcl::PointXYZ>;
+using Pose2D = rr::RelativePoseHistoryClient::Pose;
+
+/**
+ * Compose two rigid transforms, each given as the pose of one frame in another
+ * @return pose of frame c in frame a, given b in a and c in b
+ */
+Pose2D compose(const Pose2D& b_in_a, const Pose2D& c_in_b) {
+    Pose2D c_in_a;
+    c_in_a.x = b_in_a.x + std::cos(b_in_a.theta) * c_in_b.x - std::sin(b_in_a.theta) * c_in_b.y;
+    c_in_a.y = b_in_a.y + std::sin(b_in_a.theta) * c_in_b.x + std::cos(b_in_a.theta) * c_in_b.y;
+    c_in_a.theta = rr::fix_angle(b_in_a.theta + c_in_b.theta);
+    return c_in_a;
+}
 
-struct SourcePair {
-    PointCloud cloud;
-    ros::Time time;
-};
+/**
+ * @return pose of frame a in frame b, given b in a
+ */
+Pose2D invert(const Pose2D& b_in_a) {
+    Pose2D a_in_b;
+    a_in_b.x = -std::cos(b_in_a.theta) * b_in_a.x - std::sin(b_in_a.theta) * b_in_a.y;
+    a_in_b.y = std::sin(b_in_a.theta) * b_in_a.x - std::cos(b_in_a.theta) * b_in_a.y;
+    a_in_b.theta = -b_in_a.theta;
+    return a_in_b;
+}
 
-// global variables for PointCloud transformation
-std::deque<SourcePair> sources;
-rr::RelativePoseHistoryClient pose_history;
-PointCloud::Ptr local_map_unfiltered;
-
-// other global variables
-ros::Publisher map_publisher;
-pcl::VoxelGrid<pcl::PointXYZ> filter;
-ros::Duration time_horizon;
-std::vector<geometry_msgs::Point> in_frame_polygon;
-
-void obstacles_callback(const sensor_msgs::PointCloud2::ConstPtr& msg) {
-    // populate new source pair
-    auto& new_source = sources.emplace_front();
-    pcl::fromROSMsg<pcl::PointXYZ>(*msg, new_source.cloud);
-    new_source.time = msg->header.stamp;
-
-    // remove old sources
-    while (sources.back().time + time_horizon < new_source.time) {
-        sources.pop_back();
-    }
+/**
+ * Apply a rigid transform, given as the pose of the point's frame in the output frame, to a point
+ */
+pcl::PointXYZ transform_point(const Pose2D& transform, const pcl::PointXYZ& pt) {
+    const double c = std::cos(transform.theta);
+    const double s = std::sin(transform.theta);
+    return { static_cast<float>(transform.x + c * pt.x - s * pt.y),
+             static_cast<float>(transform.y + s * pt.x + c * pt.y), pt.z };
+}
 
-    // handle rosbag time loop
-    if (sources.back().time > sources.front().time) {
-        sources.erase(sources.begin() + 1, sources.end());
+/**
+ * Move half-planes into another frame
+ * @param transform Pose of the half-planes' frame in the output frame
+ */
+std::vector<rr::RollingGrid::HalfPlane> transform_half_planes(const Pose2D& transform,
+                                                              const std::vector<rr::RollingGrid::HalfPlane>& planes) {
+    // a point p in the output frame is R^T (p - t) in the half-planes' frame
+    const double c = std::cos(transform.theta);
+    const double s = std::sin(transform.theta);
+    std::vector<rr::RollingGrid::HalfPlane> out;
+    out.reserve(planes.size());
+    for (const auto& h : planes) {
+        const double a = c * h.a - s * h.b;
+        const double b = s * h.a + c * h.b;
+        out.push_back({ a, b, h.c + a * transform.x + b * transform.y });
     }
+    return out;
+}
 
-    // build map
-    bool is_newest_source = true;
-    local_map_unfiltered->clear();
-    for (auto& source : sources) {
-        // look up source point cloud, time of publication, and offset from current
-        // to source
-        const auto relative_pose_2d = pose_history.GetRelativePoseAtTime(source.time);
-
-        // construct Transform object for offset from current pose to source pose
-        tf::Quaternion rotation = tf::createQuaternionFromYaw(relative_pose_2d.theta);
-        tf::Vector3 translation = { relative_pose_2d.x, relative_pose_2d.y, 0 };
-        tf::Transform transform(rotation, translation);
-
-        // apply linear transformation
-        pcl::PointCloud<pcl::PointXYZ> transformed_cloud;
-        pcl_ros::transformPointCloud(source.cloud, transformed_cloud, transform);
-
-        // if this source pointcloud is not the most recent one, only keep the
-        // points
-        //   from it which are not in the current FOV
-        if (is_newest_source) {
-            local_map_unfiltered->insert(local_map_unfiltered->end(), transformed_cloud.begin(),
-                                         transformed_cloud.end());
+namespace rr {
+
+class LocalMapper : public nodelet::Nodelet {
+  private:
+    // accumulated history, in a fixed anchor frame so that old points are never re-inserted
+    std::unique_ptr<RollingGrid> grid_;  // hit counts around the vehicle, in the anchor frame
+    int min_hits_;                       // hits for a cell to be published as an obstacle
+    Pose2D frame_in_anchor_;             // pose of the newest cloud's frame in the anchor frame
+    ros::Time last_stamp_;
+    RelativePoseHistoryClient pose_history_;
+
+    ObstaclePublisher map_publisher_;
+    ObstacleSubscriber obstacles_sub_;
+    ros::Duration time_horizon_;
+    std::vector<RollingGrid::HalfPlane> fov_half_planes_;  // the camera's field of view, in the vehicle frame
+    std::thread load_info_thread_;
+    std::atomic<bool> stopping_{ false };  // set on unload, so the loader doesn't keep the destructor waiting
+
+    void ObstaclesCallback(const ObstaclePoints& cloud) {
+        const ros::Time stamp = cloud.header().stamp;
+
+        // offset from the current pose to the new cloud's
+        const auto new_in_current = pose_history_.GetRelativePoseAtTime(stamp);
+
+        if (last_stamp_.isZero() || stamp < last_stamp_) {
+            // first cloud, or rosbag time loop: start over with the anchor frame at this cloud
+            grid_->Clear();
+            frame_in_anchor_ = Pose2D();
         } else {
-            for (int point_idx = transformed_cloud.size() - 1; point_idx >= 0; point_idx--) {
-                const auto& pt = transformed_cloud.points[point_idx];
-                bool add;
-                if (pt.x < in_frame_polygon[0].x) {
-                    add = true;
-                } else {
-                    bool inside_all = true;
-                    for (int i = 0; i < 4; i++) {
-                        const auto& border1 = in_frame_polygon[i];
-                        const auto& border2 = in_frame_polygon[(i + 1) % 4];
-                        Eigen::Vector2d diff(pt.x - border1.x, pt.y - border1.y);
-                        Eigen::Vector2d normal(border1.y - border2.y, border2.x - border1.x);
-
-                        inside_all &= (normal.dot(diff) > 0);
-                        if (!inside_all) {
-                            break;
-                        }
-                    }
-                    add = !inside_all;
-                }
-
-                if (add) {
-                    local_map_unfiltered->push_back(pt);
-                } else {
-                    source.cloud.erase(source.cloud.begin() + point_idx);
-                }
-            }
+            // only the motion since the previous cloud is applied; the history stays where it is
+            frame_in_anchor_ = compose(frame_in_anchor_, pose_history_.GetRelativePose(last_stamp_, stamp));
         }
+        last_stamp_ = stamp;
+        grid_->Recenter(frame_in_anchor_.x, frame_in_anchor_.y);
 
-        is_newest_source = false;
-    }
+        // drop old cells, and those the new cloud sees again
+        grid_->Expire(stamp.toSec() - time_horizon_.toSec());
+        if (!fov_half_planes_.empty()) {  // no half-planes would clear the whole grid
+            grid_->ClearInside(transform_half_planes(frame_in_anchor_, fov_half_planes_));
+        }
 
-    // filter using VoxelGrid
-    PointCloud local_map;
-    filter.setInputCloud(local_map_unfiltered);
-    filter.filter(local_map);
-
-    // publish message
-    sensor_msgs::PointCloud2 map_msg;
-    pcl::toROSMsg(local_map, map_msg);
-    map_msg.header.stamp = sources.front().time;  // use time from most recent included point cloud
-    map_msg.header.frame_id = "base_footprint";
-    map_publisher.publish(map_msg);
-}
+        // insert the new cloud, once
+        cloud.ForEach([&](float x, float y) {
+            const auto anchor_pt = transform_point(frame_in_anchor_, pcl::PointXYZ(x, y, 0));
+            grid_->AddHit(anchor_pt.x, anchor_pt.y, stamp.toSec());
+        });
+
+        // build map in the current frame, one point per occupied cell
+        const Pose2D anchor_in_current = compose(new_in_current, invert(frame_in_anchor_));
+        PointCloud local_map;
+        grid_->ForEachOccupied(min_hits_, [&](double x, double y, uint16_t, double) {
+            local_map.push_back(transform_point(anchor_in_current, pcl::PointXYZ(x, y, 0)));
+        });
+
+        // publish message
+        std_msgs::Header map_header;
+        map_header.stamp = stamp;  // use time from most recent included point cloud
+        map_header.frame_id = "base_footprint";
+        map_publisher_.Publish(map_header, local_map);
+    }
 
-int main(int argc, char** argv) {
-    ros::init(argc, argv, "local_mapper");
-
-    ros::NodeHandle nh;
-    ros::NodeHandle nhp("~");
-
-    std::string obstacles_topic;
-    nhp.getParam("current_obstacles_topic", obstacles_topic);
-
-    double time_horizon_tmp;
-    nhp.getParam("time_horizon", time_horizon_tmp);
-    time_horizon = ros::Duration(time_horizon_tmp);
-
-    std::string cam_info_topic;
-    nhp.getParam("camera_info_topic", cam_info_topic);
-    std::string cam_link_name;
-    nhp.getParam("camera_link_name", cam_link_name);
-    rr::CameraGeometry camera_geometry;
-    camera_geometry.LoadInfo(nh, cam_info_topic, cam_link_name, 300);
-
-    // proportion of each side of the image that should *not* be considered part
-    // of the
-    //   field of view
-    double keep_border_prop;
-    nhp.getParam("keep_border_prop", keep_border_prop);
-
-    // find FOV convex polygon
-    int horizon_row = 0;
-    for (int row = 0; row < camera_geometry.GetImageHeight(); row++) {
-        auto [crossed_horizon, projection] = camera_geometry.ProjectToWorld(row, 0);
-        if (crossed_horizon && projection.x < 100) {
-            horizon_row = row;
-            break;
+    /**
+     * Find the camera's field of view as half-planes in the vehicle frame, leaving none if the camera info never came
+     * @return false if the nodelet is unloading
+     */
+    bool LoadFieldOfView(const std::string& cam_info_topic, const std::string& cam_link_name, double keep_border_prop) {
+        auto nh = getNodeHandle();
+        CameraGeometry camera_geometry;
+
+        // LoadInfo waits for simulated time to start too, but without a way out
+        while (!stopping_ && ros::ok() && ros::Time::now().isZero()) {
+            ros::WallDuration(0.01).sleep();
+        }
+        // short attempts, up to the usual 300 s in total, so that unloading is noticed promptly
+        const ros::Time give_up = ros::Time::now() + ros::Duration(300);
+        bool loaded = false;
+        while (!loaded && !stopping_ && ros::ok() && ros::Time::now() < give_up) {
+            loaded = camera_geometry.LoadInfo(nh, cam_info_topic, cam_link_name, 1.0);
+        }
+        if (stopping_) {
+            return false;
+        }
+        if (!loaded) {
+            // a default camera would give a made-up field of view, so cells only expire instead
+            NODELET_WARN("No camera info on %s; obstacles won't be cleared from the field of view",
+                         cam_info_topic.c_str());
+            return true;
         }
-    }
 
-    const auto w1 = static_cast<int>(camera_geometry.GetImageWidth() * keep_border_prop);
-    const auto w2 = camera_geometry.GetImageWidth() - w1;
-    const auto h1 = static_cast<int>(camera_geometry.GetImageHeight() * 0.8);
-    in_frame_polygon.push_back(std::get<1>(camera_geometry.ProjectToWorld(h1, w1)));
-    in_frame_polygon.push_back(std::get<1>(camera_geometry.ProjectToWorld(h1, w2)));
-    in_frame_polygon.push_back(std::get<1>(camera_geometry.ProjectToWorld(horizon_row, w2)));
-    in_frame_polygon.push_back(std::get<1>(camera_geometry.ProjectToWorld(horizon_row, w1)));
+        // find FOV convex polygon
+        int horizon_row = 0;
+        for (int row = 0; row < camera_geometry.GetImageHeight(); row++) {
+            auto [crossed_horizon, projection] = camera_geometry.ProjectToWorld(row, 0);
+            if (crossed_horizon && projection.x < 100) {
+                horizon_row = row;
+                break;
+            }
+        }
 
-    auto sub1 = nh.subscribe(obstacles_topic, 1, obstacles_callback);
-    auto sub2 = pose_history.RegisterCallback(nh);
+        const auto w1 = static_cast<int>(camera_geometry.GetImageWidth() * keep_border_prop);
+        const auto w2 = camera_geometry.GetImageWidth() - w1;
+        const auto h1 = static_cast<int>(camera_geometry.GetImageHeight() * 0.8);
+        std::vector<geometry_msgs::Point> in_frame_polygon;
+        in_frame_polygon.push_back(std::get<1>(camera_geometry.ProjectToWorld(h1, w1)));
+        in_frame_polygon.push_back(std::get<1>(camera_geometry.ProjectToWorld(h1, w2)));
+        in_frame_polygon.push_back(std::get<1>(camera_geometry.ProjectToWorld(horizon_row, w2)));
+        in_frame_polygon.push_back(std::get<1>(camera_geometry.ProjectToWorld(horizon_row, w1)));
+
+        // inside is to the left of each edge, and ahead of the first corner
+        for (int i = 0; i < 4; i++) {
+            const auto& border1 = in_frame_polygon[i];
+            const auto& border2 = in_frame_polygon[(i + 1) % 4];
+            const double a = border1.y - border2.y;
+            const double b = border2.x - border1.x;
+            fov_half_planes_.push_back({ a, b, a * border1.x + b * border1.y });
+        }
+        fov_half_planes_.push_back({ 1, 0, in_frame_polygon[0].x });
+        return true;
+    }
 
-    map_publisher = nh.advertise<sensor_msgs::PointCloud2>("/local_map", 1);
+    void onInit() override {
+        auto nh = getNodeHandle();
+        auto nhp = getPrivateNodeHandle();
+
+        std::string obstacles_topic;
+        nhp.getParam("current_obstacles_topic", obstacles_topic);
+
+        double time_horizon_tmp;
+        nhp.getParam("time_horizon", time_horizon_tmp);
+        time_horizon_ = ros::Duration(time_horizon_tmp);
+
+        std::string cam_info_topic;
+        nhp.getParam("camera_info_topic", cam_info_topic);
+        std::string cam_link_name;
+        nhp.getParam("camera_link_name", cam_link_name);
+
+        // proportion of each side of the image that should *not* be considered part
+        // of the
+        //   field of view
+        double keep_border_prop;
+        nhp.getParam("keep_border_prop", keep_border_prop);
+
+        pose_history_.Attach(nh);
+
+        map_publisher_ = ObstaclePublisher(nh, "/local_map");
+
+        // the window should cover the planner's map, since the vehicle's in its center
+        RollingGrid::Params grid_params{};
+        double map_size;
+        nhp.param("map_resolution", grid_params.resolution, 0.05);
+        nhp.param("map_size", map_size, 20.0);
+        nhp.param("min_hits", min_hits_, 1);
+        grid_params.size = static_cast<int>(std::ceil(map_size / grid_params.resolution));
+        grid_ = std::make_unique<RollingGrid>(grid_params);
+
+        // the camera info can take a while, and the manager's other nodelets shouldn't wait on it
+        load_info_thread_ = std::thread([this, obstacles_topic, cam_info_topic, cam_link_name, keep_border_prop]() {
+            if (!LoadFieldOfView(cam_info_topic, cam_link_name, keep_border_prop)) {
+                return;
+            }
+            auto nh = getNodeHandle();
+            obstacles_sub_.Subscribe(nh, obstacles_topic,
+                                     [this](const ObstaclePoints& cloud) { ObstaclesCallback(cloud); });
+            NODELET_INFO("Local mapper subscribed to %s", obstacles_topic.c_str());
+        });
+    }
 
-    local_map_unfiltered.reset(new PointCloud);
+  public:
+    ~LocalMapper() override {
+        stopping_ = true;
+        if (load_info_thread_.joinable()) {
+            load_info_thread_.join();
+        }
+    }
+};
 
-    filter.setLeafSize(0.05, 0.05, 0.05);
+}  // namespace rr
 
-    ros::spin();
-    return 0;
-}
+PLUGINLIB_EXPORT_CLASS(rr::LocalMapper, nodelet::Nodelet);
@@ -1,30 +1,26 @@
-#include <parameter_assertions/assertions.h>
 #include <rr_common/planning/annealing_optimizer.h>
 #include <rr_common/planning/planning_utils.h>
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace rr {
 
 template class AnnealingOptimizer<1>;
 template class AnnealingOptimizer<2>;
 
 template <int ctrl_dim>
-AnnealingOptimizer<ctrl_dim>::AnnealingOptimizer(const ros::NodeHandle& nh)
-      : params_(), uniform_01_(0, 1), rand_gen_(42) {
-    assertions::getParam(nh, "annealing_steps", params_.annealing_steps, { assertions::greater(0) });
-    assertions::getParam(nh, "acceptance_scale", params_.acceptance_scale, { assertions::greater(0.0) });
-    assertions::getParam(nh, "temperature_end", params_.temperature_end, { assertions::greater(0.0) });
-
-    std::vector<double> stddev_start;
-    assertions::getParam(nh, "stddevs_start", stddev_start, { assertions::size<std::vector<double>>(ctrl_dim) });
-
-    for (size_t i = 0; i < ctrl_dim; ++i) {
-        ROS_ASSERT(stddev_start[i] > 0);
-        params_.stddev_start(i) = stddev_start[i];
+AnnealingOptimizer<ctrl_dim>::AnnealingOptimizer(const Params& params)
+      : params_(params), uniform_01_(0, 1), rand_gen_(42) {
+    if (params_.num_chains <= 1 && params_.batch_size > 1) {
+        int threads = std::min<int>(params_.batch_size, std::max(std::thread::hardware_concurrency(), 1u));
+        worker_pool_ = std::make_unique<WorkerPool>(threads - 1);
     }
 }
 
 template <int ctrl_dim>
-double AnnealingOptimizer<ctrl_dim>::GetTemperature(unsigned int t) {
+real_t AnnealingOptimizer<ctrl_dim>::GetTemperature(unsigned int t) {
     return std::exp(t * std::log(params_.temperature_end) / params_.annealing_steps);
 }
 
@@ -32,18 +28,25 @@ template <int ctrl_dim>
 Controls<ctrl_dim> AnnealingOptimizer<ctrl_dim>::Optimize(const CostFunction<ctrl_dim>& cost_fn,
                                                           const Controls<ctrl_dim>& init_controls,
                                                           const Matrix<ctrl_dim, 2>& ctrl_limits) {
+    if (params_.num_chains > 1) {
+        return OptimizeTempering(cost_fn, init_controls, ctrl_limits);
+    }
+    if (worker_pool_) {
+        return OptimizeBatch(cost_fn, init_controls, ctrl_limits);
+    }
+
     auto controls_state = init_controls;
     auto controls_best = init_controls;
-    double cost_state = cost_fn(init_controls);
-    double cost_best = cost_state;
+    real_t cost_state = cost_fn(init_controls);
+    real_t cost_best = cost_state;
 
     for (int t = 0; t < params_.annealing_steps; t++) {
-        double temperature = GetTemperature(t);
+        real_t temperature = GetTemperature(t);
         Vector<ctrl_dim> stddevs = params_.stddev_start / temperature;
-        auto controls_new = controls_neighbor(controls_state, ctrl_limits, stddevs);
-        double cost_new = cost_fn(controls_new);
+        auto controls_new = controls_neighbor(controls_state, ctrl_limits, stddevs, rand_gen_);
+        real_t cost_new = cost_fn(controls_new);
 
-        double dcost = cost_new - cost_state;
+        real_t dcost = cost_new - cost_state;
         if (dcost < 0) {
             controls_state = controls_new;
             cost_state = cost_new;
@@ -64,4 +67,154 @@ Controls<ctrl_dim> AnnealingOptimizer<ctrl_dim>::Optimize(const CostFunction<ctr
     return controls_best;
 }
 
+template <int ctrl_dim>
+Controls<ctrl_dim> AnnealingOptimizer<ctrl_dim>::OptimizeTempering(const CostFunction<ctrl_dim>& cost_fn,
+                                                                   const Controls<ctrl_dim>& init_controls,
+                                                                   const Matrix<ctrl_dim, 2>& ctrl_limits) {
+    struct Chain {
+        Controls<ctrl_dim> controls_state;
+        real_t cost_state;
+        Controls<ctrl_dim> controls_best;
+        real_t cost_best;
+        std::mt19937 rand_gen;
+    };
+
+    const int num_chains = params_.num_chains;
+    const int swap_interval = std::max(params_.swap_interval, 1);
+    const real_t ladder = std::pow(params_.temperature_end, -1.0 / num_chains);
+    auto chain_temperature = [this, ladder](int chain, int t) { return GetTemperature(t) * std::pow(ladder, chain); };
+
+    const real_t init_cost = cost_fn(init_controls);
+    std::vector<Chain> chains;
+    for (int c = 0; c < num_chains; ++c) {
+        chains.push_back({ init_controls, init_cost, init_controls, init_cost, std::mt19937(rand_gen_()) });
+    }
+
+    // exchange states between adjacent chains, alternating between even and odd pairs
+    int exchange_round = 0;
+    auto exchange = [&](int t) {
+        for (int c = exchange_round % 2; c + 1 < num_chains; c += 2) {
+            Chain& cold = chains[c];
+            Chain& hot = chains[c + 1];
+            real_t beta_cold = params_.acceptance_scale / chain_temperature(c, t);
+            real_t beta_hot = params_.acceptance_scale / chain_temperature(c + 1, t);
+            double p_swap = std::exp((beta_cold - beta_hot) * (cold.cost_state - hot.cost_state));
+            if (uniform_01_(rand_gen_) < p_swap) {
+                std::swap(cold.controls_state, hot.controls_state);
+                std::swap(cold.cost_state, hot.cost_state);
+            }
+        }
+        exchange_round++;
+    };
+
+    // all chains stop at the same step for each exchange; the last one to arrive runs it
+    std::mutex barrier_mutex;
+    std::condition_variable barrier_cv;
+    int arrived = 0;
+    int generation = 0;
+
+    auto worker = [&, this](int c) {
+        Chain& chain = chains[c];
+        std::uniform_real_distribution<double> uniform_01(0, 1);
+
+        for (int start = 0; start < params_.annealing_steps; start += swap_interval) {
+            const int end = std::min(start + swap_interval, params_.annealing_steps);
+            for (int t = start; t < end; ++t) {
+                real_t temperature = chain_temperature(c, t);
+                Vector<ctrl_dim> stddevs = params_.stddev_start / temperature;
+                auto controls_new = controls_neighbor(chain.controls_state, ctrl_limits, stddevs, chain.rand_gen);
+                real_t cost_new = cost_fn(controls_new);
+
+                real_t dcost = cost_new - chain.cost_state;
+                if (dcost < 0 ||
+                    uniform_01(chain.rand_gen) < std::exp(-params_.acceptance_scale * dcost / temperature)) {
+                    chain.controls_state = controls_new;
+                    chain.cost_state = cost_new;
+                }
+
+                if (cost_new < chain.cost_best) {
+                    chain.controls_best = controls_new;
+                    chain.cost_best = cost_new;
+                }
+            }
+
+            std::unique_lock lock(barrier_mutex);
+            const int my_generation = generation;
+            if (++arrived == num_chains) {
+                exchange(end);
+                arrived = 0;
+                generation++;
+                barrier_cv.notify_all();
+            } else {
+                barrier_cv.wait(lock, [&] { return generation != my_generation; });
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int c = 0; c < num_chains; ++c) {
+        threads.emplace_back(worker, c);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    auto best = std::min_element(chains.begin(), chains.end(),
+                                 [](const Chain& a, const Chain& b) { return a.cost_best < b.cost_best; });
+    return best->controls_best;
+}
+
+template <int ctrl_dim>
+Controls<ctrl_dim> AnnealingOptimizer<ctrl_dim>::OptimizeBatch(const CostFunction<ctrl_dim>& cost_fn,
+                                                               const Controls<ctrl_dim>& init_controls,
+                                                               const Matrix<ctrl_dim, 2>& ctrl_limits) {
+    const int batch_size = params_.batch_size;
+    const int steps = (params_.annealing_steps + batch_size - 1) / batch_size;
+
+    auto controls_state = init_controls;
+    auto controls_best = init_controls;
+    real_t cost_state = cost_fn(init_controls);
+    real_t cost_best = cost_state;
+
+    std::vector<std::mt19937> rand_gens;
+    for (int i = 0; i < batch_size; ++i) {
+        rand_gens.emplace_back(rand_gen_());
+    }
+    std::vector<Controls<ctrl_dim>> neighbors(batch_size);
+    std::vector<real_t> costs(batch_size);
+    std::vector<double> weights(batch_size);
+
+    for (int step = 0; step < steps; step++) {
+        real_t temperature = GetTemperature(step * batch_size);
+        Vector<ctrl_dim> stddevs = params_.stddev_start / temperature;
+
+        worker_pool_->ParallelFor(batch_size, [&](int i) {
+            neighbors[i] = controls_neighbor(controls_state, ctrl_limits, stddevs, rand_gens[i]);
+            costs[i] = cost_fn(neighbors[i]);
+        });
+
+        const int best = std::min_element(costs.begin(), costs.end()) - costs.begin();
+        int chosen = best;
+        if (params_.batch_sample) {
+            for (int i = 0; i < batch_size; ++i) {
+                weights[i] = std::exp(-params_.acceptance_scale * (costs[i] - costs[best]) / temperature);
+            }
+            chosen = std::discrete_distribution<int>(weights.begin(), weights.end())(rand_gen_);
+        }
+
+        real_t dcost = costs[chosen] - cost_state;
+        if (dcost < 0 || uniform_01_(rand_gen_) < std::exp(-params_.acceptance_scale * dcost / temperature)) {
+            controls_state = neighbors[chosen];
+            cost_state = costs[chosen];
+        }
+
+        if (costs[best] < cost_best) {
+            controls_best = neighbors[best];
+            cost_best = costs[best];
+        }
+    }
+
+    return controls_best;
+}
+
 }  // namespace rr
@@ -1,102 +1,228 @@
 #include <rr_common/planning/bicycle_model.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace rr {
 
-BicycleModel::BicycleModel(const ros::NodeHandle& nh, const std::shared_ptr<rr::LinearTrackingFilter>& steer_model_ptr,
-                           const std::shared_ptr<rr::LinearTrackingFilter>& speed_model_ptr) {
-    assertions::getParam(nh, "segment_size", segment_size_);
-    assertions::getParam(nh, "dt", dt_);
-    assertions::getParam(nh, "wheel_base", wheel_base_);
-    assertions::getParam(nh, "lateral_accel", max_lateral_accel_);
+namespace {
+
+constexpr int kDistanceTableSize = 64;
+constexpr int kSineTableSize = 4096;
+
+/**
+ * Linear interpolation at a fractional index, clamped to the table
+ */
+inline real_t Interpolate(const std::vector<real_t>& table, real_t index) {
+    index = std::clamp(index, real_t(0), real_t(table.size() - 1));
+    const auto i = std::min(static_cast<size_t>(index), table.size() - 2);
+    const real_t f = index - i;
+    return table[i] + f * (table[i + 1] - table[i]);
+}
+
+}  // namespace
+
+BicycleModel::BicycleModel(const Params& params, const std::shared_ptr<rr::LinearTrackingFilter>& steer_model_ptr,
+                           const std::shared_ptr<rr::LinearTrackingFilter>& speed_model_ptr)
+      : wheel_base_(params.wheel_base)
+      , max_lateral_accel_(params.lateral_accel)
+      , segment_size_(params.segment_size)
+      , dt_(params.dt)
+      , reverse_(params.reverse)
+      , steering_model_(steer_model_ptr)
+      , speed_model_(speed_model_ptr) {
+    if (params.lookup_table_size > 1) {
+        BuildLookupTables(params.lookup_table_size);
+    }
+}
+
+void BicycleModel::BuildLookupTables(int steer_size) {
+    auto tables = std::make_shared<LookupTables>();
+
+    real_t steer_min = steering_model_->GetValMin();
+    real_t steer_max = std::max<real_t>(steering_model_->GetValMax(), steer_min + real_t(1e-3));
+    real_t dist_min = std::min<real_t>(speed_model_->GetValMin() * dt_, 0);
+    real_t dist_max = std::max<real_t>(speed_model_->GetValMax() * dt_, dist_min + real_t(1e-3));
+
+    tables->steer_size = steer_size;
+    tables->steer_min = steer_min;
+    tables->steer_scale = (steer_size - 1) / (steer_max - steer_min);
+    tables->dist_size = kDistanceTableSize;
+    tables->dist_min = dist_min;
+    tables->dist_scale = (kDistanceTableSize - 1) / (dist_max - dist_min);
+
+    tables->delta_x.resize(steer_size * kDistanceTableSize);
+    tables->delta_y.resize(steer_size * kDistanceTableSize);
+    tables->heading_rate.resize(steer_size);
+
+    for (int si = 0; si < steer_size; ++si) {
+        const real_t steer = steer_min + si / tables->steer_scale;
+        for (int di = 0; di < kDistanceTableSize; ++di) {
+            const real_t distance = dist_min + di / tables->dist_scale;
+            real_t delta_theta;
+            const int index = si * kDistanceTableSize + di;
+            ComputeStep(steer, distance, tables->delta_x[index], tables->delta_y[index], delta_theta);
+        }
+        // heading change is linear in distance, but ComputeStep zeroes it below 1e-7 rad of steering
+        tables->heading_rate[si] = std::sin(-steer) / wheel_base_;
+    }
+
+    tables->sine_size = kSineTableSize;
+    tables->sine.resize(kSineTableSize + 1);
+    for (int i = 0; i <= kSineTableSize; ++i) {
+        tables->sine[i] = std::sin(2 * M_PI * i / kSineTableSize);
+    }
 
-    steering_model_ = steer_model_ptr;
-    speed_model_ = speed_model_ptr;
+    tables_ = tables;
 }
 
 void BicycleModel::RollOutPath(const Controls<1>& controls, TrajectoryRollout& rollout) const {
     const size_t path_size = 1 + (segment_size_ * controls.cols());
-    if (rollout.path.size() != path_size) {
-        rollout.path.resize(static_cast<size_t>(path_size));
+    Path& path = rollout.path;
+    if (path.size() != path_size) {
+        path.resize(path_size);
     }
 
-    rollout.path[0].pose.x = 0;
-    rollout.path[0].pose.y = 0;
-    rollout.path[0].pose.theta = 0;
-    rollout.path[0].speed = speed_model_->GetValue();
-    rollout.path[0].steer = steering_model_->GetValue();
-    rollout.path[0].time = 0;
+    path.x[0] = 0;
+    path.y[0] = 0;
+    path.theta[0] = 0;
+    path.speed[0] = speed_model_->GetValue();
+    path.steer[0] = steering_model_->GetValue();
+    path.time[0] = 0;
 
     rollout.apply_steering = controls(0);
 
     rr::LinearTrackingFilter steering_model_temp = *steering_model_;  // copy
     rr::LinearTrackingFilter speed_model_temp = *speed_model_;
 
-    int i = 1;
+    const real_t min_speed = speed_model_->GetValMin();
+    real_t first_speed_target = 0;
+
+    size_t i = 1;
     for (int segment = 0; segment < controls.cols(); segment++) {
         steering_model_temp.SetTarget(controls(segment));
 
         for (auto j = i; j < i + segment_size_; j++) {
-            const PathPoint& last_path_point = rollout.path[j - 1];
-            PathPoint& path_point = rollout.path[j];
-
-            StepKinematics(last_path_point, path_point.pose);
+            StepKinematics(path, j);
 
             steering_model_temp.UpdateRawDT(dt_);
 
-            speed_model_temp.SetTarget(SteeringToSpeed(steering_model_temp.GetValue()));
+            real_t speed_target = SteeringToSpeed(steering_model_temp.GetValue());
+            if (reverse_) {
+                speed_target = std::max(-speed_target, min_speed);
+            }
+            if (j == 1) {
+                first_speed_target = speed_target;
+            }
+            speed_model_temp.SetTarget(speed_target);
             speed_model_temp.UpdateRawDT(dt_);
 
-            path_point.steer = steering_model_temp.GetValue();
-            path_point.speed = speed_model_temp.GetValue();
-            path_point.time = last_path_point.time + dt_;
+            path.steer[j] = steering_model_temp.GetValue();
+            path.speed[j] = speed_model_temp.GetValue();
+            path.time[j] = path.time[j - 1] + dt_;
         }
 
         i += segment_size_;
     }
 
-    speed_model_temp.Reset(rollout.path.back().speed, 0);
+    if (reverse_) {
+        // reversing speeds are low enough to stop from at any point, so command the target directly
+        rollout.apply_speed = first_speed_target;
+        return;
+    }
+
+    speed_model_temp.Reset(path.speed.back(), 0);
     for (i = path_size - 1; i >= 1; --i) {
-        speed_model_temp.SetTarget(rollout.path[i].speed);
+        speed_model_temp.SetTarget(path.speed[i]);
         speed_model_temp.UpdateRawDT(-dt_);
-        rollout.path[i - 1].speed = std::min(rollout.path[i - 1].speed, speed_model_temp.GetValue());
+        path.speed[i - 1] = std::min<real_t>(path.speed[i - 1], speed_model_temp.GetValue());
     }
     rollout.apply_speed = speed_model_temp.GetValue();
 }
 
-void BicycleModel::StepKinematics(const PathPoint& prev, Pose& next) const {
-    double deltaX, deltaY, deltaTheta;
-    double distance_increment = prev.speed * dt_;
+void BicycleModel::StepKinematics(Path& path, size_t i) const {
+    const real_t prev_steer = path.steer[i - 1];
+    const real_t prev_theta = path.theta[i - 1];
+    const real_t distance_increment = path.speed[i - 1] * dt_;
+
+    real_t deltaX, deltaY, deltaTheta, cos_th, sin_th;
+    if (tables_) {
+        const LookupTables& t = *tables_;
+
+        const real_t s = std::clamp((prev_steer - t.steer_min) * t.steer_scale, real_t(0), real_t(t.steer_size - 1));
+        const int si = std::min(static_cast<int>(s), t.steer_size - 2);
+        const real_t sf = s - si;
+        const real_t d = std::clamp((distance_increment - t.dist_min) * t.dist_scale, real_t(0),
+                                    real_t(t.dist_size - 1));
+        const int di = std::min(static_cast<int>(d), t.dist_size - 2);
+        const real_t df = d - di;
+
+        auto bilinear = [&](const std::vector<real_t>& table) {
+            const real_t* row0 = &table[si * t.dist_size + di];
+            const real_t* row1 = row0 + t.dist_size;
+            real_t a = row0[0] + df * (row0[1] - row0[0]);
+            real_t b = row1[0] + df * (row1[1] - row1[0]);
+            return a + sf * (b - a);
+        };
+        deltaX = bilinear(t.delta_x);
+        deltaY = bilinear(t.delta_y);
+        deltaTheta = distance_increment * (t.heading_rate[si] + sf * (t.heading_rate[si + 1] - t.heading_rate[si]));
+
+        real_t phase = prev_theta * real_t(t.sine_size / (2 * M_PI));
+        phase -= std::floor(phase / t.sine_size) * t.sine_size;
+        real_t cos_phase = phase + t.sine_size / 4;
+        cos_phase -= (cos_phase >= t.sine_size) ? t.sine_size : 0;
+        sin_th = Interpolate(t.sine, phase);
+        cos_th = Interpolate(t.sine, cos_phase);
+    } else {
+        ComputeStep(prev_steer, distance_increment, deltaX, deltaY, deltaTheta);
+        cos_th = std::cos(prev_theta);
+        sin_th = std::sin(prev_theta);
+    }
+
+    path.x[i] = path.x[i - 1] + deltaX * cos_th - deltaY * sin_th;
+    path.y[i] = path.y[i - 1] + deltaX * sin_th + deltaY * cos_th;
+    path.theta[i] = prev_theta + deltaTheta;
+}
 
-    if (std::abs(prev.steer) < 1e-7) {
+void BicycleModel::ComputeStep(real_t prev_steer, real_t distance_increment, real_t& deltaX, real_t& deltaY,
+                               real_t& deltaTheta) const {
+    if (std::abs(prev_steer) < real_t(1e-7)) {
         deltaX = distance_increment;
         deltaY = 0;
         deltaTheta = 0;
     } else {
-        double turn_radius = wheel_base_ / std::tan(std::abs(prev.steer));
-        double tempTheta = distance_increment / turn_radius;
-        deltaX = turn_radius * std::cos(M_PI / 2 - tempTheta);
-        if (prev.steer < 0) {
-            deltaY = turn_radius - turn_radius * std::sin(M_PI / 2 - tempTheta);
+        real_t turn_radius = wheel_base_ / std::tan(std::abs(prev_steer));
+        real_t tempTheta = distance_increment / turn_radius;
+        deltaX = turn_radius * std::cos(real_t(M_PI / 2) - tempTheta);
+        if (prev_steer < 0) {
+            deltaY = turn_radius - turn_radius * std::sin(real_t(M_PI / 2) - tempTheta);
         } else {
-            deltaY = -(turn_radius - turn_radius * std::sin(M_PI / 2 - tempTheta));
+            deltaY = -(turn_radius - turn_radius * std::sin(real_t(M_PI / 2) - tempTheta));
         }
-        deltaTheta = distance_increment / wheel_base_ * std::sin(-prev.steer);
+        deltaTheta = distance_increment / wheel_base_ * std::sin(-prev_steer);
     }
-
-    next.x = prev.pose.x + deltaX * std::cos(prev.pose.theta) - deltaY * std::sin(prev.pose.theta);
-    next.y = prev.pose.y + deltaX * std::sin(prev.pose.theta) + deltaY * std::cos(prev.pose.theta);
-    next.theta = prev.pose.theta + deltaTheta;
 }
 
-double BicycleModel::SteeringToSpeed(double steer_angle) const {
-    steer_angle = std::abs(steer_angle);
-
-    double out;
-    if (steer_angle < 1e-3) {
-        out = speed_model_->GetValMax();
+real_t BicycleModel::SteeringToSpeed(real_t steer_angle) const {
+    const real_t v_max = speed_model_->GetValMax();
+
+    real_t out;
+    if (std::abs(steer_angle) < real_t(1e-3)) {
+        out = v_max;
+    } else if (tables_) {
+        // max_lateral_accel_ * wheel_base_ / sin(steer) == max_lateral_accel_ / heading_rate. Interpolating the smooth
+        // heading rate instead of the capped speed keeps the corner where the cap meets the max speed sharp
+        const real_t heading_rate = std::abs(
+                Interpolate(tables_->heading_rate, (steer_angle - tables_->steer_min) * tables_->steer_scale));
+        if (heading_rate * v_max * v_max <= max_lateral_accel_) {
+            out = v_max;
+        } else {
+            out = std::sqrt(max_lateral_accel_ / heading_rate);
+        }
     } else {
-        double vRaw = std::sqrt(max_lateral_accel_ * wheel_base_ / std::sin(steer_angle));
-        out = std::min(vRaw, speed_model_->GetValMax());
+        real_t vRaw = std::sqrt(max_lateral_accel_ * wheel_base_ / std::sin(std::abs(steer_angle)));
+        out = std::min<real_t>(vRaw, v_max);
     }
     return out;
 }
@@ -0,0 +1,60 @@
+#include <rr_common/planning/coarse_to_fine.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace rr {
+
+namespace {
+
+HillClimbOptimizer<1>::Params RefinerParams(const CoarseToFinePlanner::Params& params) {
+    HillClimbOptimizer<1>::Params refiner_params;
+    refiner_params.num_workers = 1;
+    refiner_params.num_restarts = 1;  // the only start is the warm start, so this is a single local descent
+    refiner_params.neighbor_stddev = params.refine_stddev;
+    refiner_params.local_optimum_tries = params.refine_tries;
+    return refiner_params;
+}
+
+}  // namespace
+
+CoarseToFinePlanner::CoarseToFinePlanner(const Params& params, const BicycleModel::Params& model_params,
+                                         int n_segments,
+                                         const std::shared_ptr<rr::LinearTrackingFilter>& steer_model_ptr,
+                                         const std::shared_ptr<rr::LinearTrackingFilter>& speed_model_ptr)
+      : levels_(params.levels), refiner_(RefinerParams(params)), n_segments_(n_segments) {
+    const int dt_factor = std::max(params.dt_factor, 1);
+    const double horizon_steps = static_cast<double>(model_params.segment_size) * n_segments;
+
+    for (int level : levels_) {
+        BicycleModel::Params coarse_params = model_params;
+        coarse_params.dt = model_params.dt * dt_factor;
+        coarse_params.segment_size = std::max(1, static_cast<int>(std::lround(horizon_steps / (level * dt_factor))));
+        coarse_models_.emplace_back(coarse_params, steer_model_ptr, speed_model_ptr);
+    }
+}
+
+Controls<1> CoarseToFinePlanner::Optimize(PlanningOptimizer<1>& optimizer, const CostFunctionFactory& make_cost_fn,
+                                          const BicycleModel& full_model, const Controls<1>& init_controls,
+                                          const Matrix<1, 2>& ctrl_limits) {
+    if (levels_.empty()) {
+        return optimizer.Optimize(make_cost_fn(full_model), init_controls, ctrl_limits);
+    }
+
+    // local descent from a resampled solution, keeping the start if no neighbor beats it
+    auto refine = [this, &ctrl_limits](const CostFunction<1>& cost_fn, const Controls<1>& start) {
+        Controls<1> refined = refiner_.Optimize(cost_fn, start, ctrl_limits);
+        return cost_fn(refined) < cost_fn(start) ? refined : start;
+    };
+
+    Controls<1> controls = ResampleControls(init_controls, levels_[0]);
+    controls = optimizer.Optimize(make_cost_fn(coarse_models_[0]), controls, ctrl_limits);
+
+    for (size_t i = 1; i < levels_.size(); ++i) {
+        controls = refine(make_cost_fn(coarse_models_[i]), ResampleControls(controls, levels_[i]));
+    }
+
+    return refine(make_cost_fn(full_model), ResampleControls(controls, n_segments_));
+}
+
+}  // namespace rr
@@ -0,0 +1,86 @@
+#include <Eigen/QR>
+#include <rr_common/planning/control_spline.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace rr {
+
+template class ControlSpline<1>;
+template class ControlSpline<2>;
+
+namespace {
+
+/**
+ * Cox-de Boor recursion for the value of B-spline basis function i of degree p at u
+ */
+double BasisFunction(const std::vector<double>& knots, int i, int p, double u) {
+    if (p == 0) {
+        bool last_span = (u == knots.back() && knots[i] < knots[i + 1] && knots[i + 1] == knots.back());
+        return (knots[i] <= u && u < knots[i + 1]) || last_span ? 1.0 : 0.0;
+    }
+
+    double value = 0;
+    double left_span = knots[i + p] - knots[i];
+    if (left_span > 0) {
+        value += (u - knots[i]) / left_span * BasisFunction(knots, i, p - 1, u);
+    }
+    double right_span = knots[i + p + 1] - knots[i + 1];
+    if (right_span > 0) {
+        value += (knots[i + p + 1] - u) / right_span * BasisFunction(knots, i + 1, p - 1, u);
+    }
+    return value;
+}
+
+}  // namespace
+
+template <int ctrl_dim>
+ControlSpline<ctrl_dim>::ControlSpline(int n_knots, int n_segments, int degree) {
+    n_knots = std::max(n_knots, 1);
+    const int p = std::clamp(degree, 0, n_knots - 1);
+
+    // clamped uniform knot vector: the spline starts at the first knot and ends at the last
+    std::vector<double> knot_vector;
+    for (int i = 0; i <= p; ++i) {
+        knot_vector.push_back(0);
+    }
+    for (int i = 1; i < n_knots - p; ++i) {
+        knot_vector.push_back(static_cast<double>(i) / (n_knots - p));
+    }
+    for (int i = 0; i <= p; ++i) {
+        knot_vector.push_back(1);
+    }
+
+    basis_.resize(n_knots, n_segments);
+    for (int s = 0; s < n_segments; ++s) {
+        double u = (s + 0.5) / n_segments;
+        for (int k = 0; k < n_knots; ++k) {
+            basis_(k, s) = BasisFunction(knot_vector, k, p, u);
+        }
+    }
+
+    // least squares: knots = segments * basis^T (basis basis^T)^+
+    fit_ = basis_.transpose() * (basis_ * basis_.transpose()).completeOrthogonalDecomposition().pseudoInverse();
+}
+
+template <int ctrl_dim>
+Controls<ctrl_dim> ControlSpline<ctrl_dim>::Evaluate(const Controls<ctrl_dim>& knots) const {
+    return knots * basis_;
+}
+
+template <int ctrl_dim>
+Controls<ctrl_dim> ControlSpline<ctrl_dim>::Fit(const Controls<ctrl_dim>& segments,
+                                                const Matrix<ctrl_dim, 2>& limits) const {
+    Controls<ctrl_dim> knots = segments * fit_;
+    for (int dim = 0; dim < ctrl_dim; ++dim) {
+        knots.row(dim) = knots.row(dim).cwiseMax(limits(dim, 0)).cwiseMin(limits(dim, 1));
+    }
+    return knots;
+}
+
+template <int ctrl_dim>
+CostFunction<ctrl_dim> ControlSpline<ctrl_dim>::Wrap(const CostFunction<ctrl_dim>& cost_fn) const {
+    return [this, cost_fn](const Controls<ctrl_dim>& knots) { return cost_fn(Evaluate(knots)); };
+}
+
+}  // namespace rr
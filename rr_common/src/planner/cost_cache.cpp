@@ -0,0 +1,92 @@
+#include <rr_common/planning/cost_cache.h>
+
+#include <cmath>
+#include <limits>
+
+namespace rr {
+
+template class CostCache<1>;
+template class CostCache<2>;
+
+namespace {
+
+uint64_t SplitMix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+}  // namespace
+
+template <int ctrl_dim>
+CostCache<ctrl_dim>::CostCache(size_t capacity, double resolution)
+      : mask_(0), inverse_resolution_(1.0 / resolution), hits_(0), misses_(0), wraps_(0) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    table_.reset(new Entry[size]);
+    mask_ = size - 1;
+    Clear();
+}
+
+template <int ctrl_dim>
+void CostCache<ctrl_dim>::Clear() {
+    for (size_t i = 0; i <= mask_; ++i) {
+        table_[i].key.store(0, std::memory_order_relaxed);
+        table_[i].cost.store(std::numeric_limits<real_t>::quiet_NaN(), std::memory_order_relaxed);
+    }
+    hits_ = 0;
+    misses_ = 0;
+    wraps_ = 0;
+}
+
+template <int ctrl_dim>
+uint64_t CostCache<ctrl_dim>::Key(const Controls<ctrl_dim>& controls, uint64_t salt) const {
+    uint64_t hash = SplitMix64(SplitMix64(salt) ^ static_cast<uint64_t>(controls.cols()));
+    for (long i = 0; i < controls.size(); ++i) {
+        auto quantized = static_cast<int64_t>(std::llround(controls.data()[i] * inverse_resolution_));
+        hash = SplitMix64(hash ^ static_cast<uint64_t>(quantized));
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+template <int ctrl_dim>
+CostFunction<ctrl_dim> CostCache<ctrl_dim>::Wrap(const CostFunction<ctrl_dim>& cost_fn) {
+    const uint64_t salt = wraps_.fetch_add(1, std::memory_order_relaxed);
+    return [this, cost_fn, salt](const Controls<ctrl_dim>& controls) -> real_t {
+        const uint64_t key = Key(controls, salt);
+
+        Entry* claimed = nullptr;
+        for (int probe = 0; probe < kMaxProbes; ++probe) {
+            Entry& entry = table_[(key + probe) & mask_];
+            uint64_t entry_key = entry.key.load(std::memory_order_acquire);
+
+            if (entry_key == 0) {
+                if (entry.key.compare_exchange_strong(entry_key, key, std::memory_order_acq_rel)) {
+                    claimed = &entry;
+                    break;
+                }
+                // lost the race for this slot; entry_key now holds the winner's key
+            }
+            if (entry_key == key) {
+                real_t cost = entry.cost.load(std::memory_order_acquire);
+                if (!std::isnan(cost)) {
+                    hits_.fetch_add(1, std::memory_order_relaxed);
+                    return cost;
+                }
+                break;  // another thread is computing it; don't wait
+            }
+        }
+
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        real_t cost = cost_fn(controls);
+        if (claimed) {
+            claimed->cost.store(cost, std::memory_order_release);
+        }
+        return cost;
+    };
+}
+
+}  // namespace rr
@@ -10,65 +10,62 @@
 
 namespace rr {
 
-DistanceMap::DistanceMap(ros::NodeHandle nh)
-      : distance_cost_map(), hit_box(ros::NodeHandle(nh, "hitbox")), listener(new tf::TransformListener) {
-    std::string map_topic;
-    assertions::getParam(nh, "map_topic", map_topic);
-    assertions::getParam(nh, "robot_base_frame", robot_base_frame);
-    assertions::getParam(nh, "publish_distance_map", publish_distance_map);
-    assertions::getParam(nh, "publish_inscribed_circle", publish_inscribed_circle);
-
-    assertions::getParam(nh, "cost_scaling_factor", cost_scaling_factor, { assertions::greater_eq(0.0) });
-    assertions::getParam(nh, "wall_inflation", wall_inflation, { assertions::greater_eq(0.0) });
-
-    map_sub = nh.subscribe(map_topic, 1, &DistanceMap::SetMapMessage, this);
-    distance_map_pub = nh.advertise<nav_msgs::OccupancyGrid>("distance_map", 1);
-    inscribed_circle_pub = nh.advertise<geometry_msgs::PolygonStamped>("inscribed_circle", 1);
-
+DistanceMap::DistanceMap(const Params& params)
+      : distance_map()
+      , distance_cost_map()
+      , hit_box(params.hitbox)
+      , cost_scaling_factor(params.cost_scaling_factor)
+      , wall_inflation(params.wall_inflation)
+      , map_width(0)
+      , map_height(0)
+      , map_resolution(1)
+      , map_origin_x(0)
+      , map_origin_y(0) {
     std::tie(inscribed_circle_radius, inscribed_circle_origin) = hit_box.getForwardInscribedCircle();
 }
 
-double DistanceMap::DistanceCost(const rr::Pose& pose) {
+real_t DistanceMap::DistanceCost(const rr::Pose& pose) {
     auto [mx, my] = this->PoseToGridPosition(pose);
 
-    if (my < 0 || mapMetaData.height <= my || mx < 0 || mapMetaData.width <= mx)
+    if (my < 0 || map_height <= my || mx < 0 || map_width <= mx)
         return 0.0;
 
     return distance_cost_map.at<float>(my, mx);
 }
 
 std::pair<unsigned int, unsigned int> DistanceMap::PoseToGridPosition(const rr::Pose& pose) {
-    tf::Pose w_pose = transform * tf::Pose(tf::createQuaternionFromYaw(0),
-                                           tf::Vector3(pose.x + inscribed_circle_origin, pose.y, 0));
+    const double cos_th = std::cos(robot_pose.theta);
+    const double sin_th = std::sin(robot_pose.theta);
+    const double x = pose.x + inscribed_circle_origin;
+    const double w_x = robot_pose.x + x * cos_th - pose.y * sin_th;
+    const double w_y = robot_pose.y + x * sin_th + pose.y * cos_th;
 
-    unsigned int mx = std::floor((w_pose.getOrigin().x() - mapMetaData.origin.position.x) / mapMetaData.resolution);
-    unsigned int my = std::floor((w_pose.getOrigin().y() - mapMetaData.origin.position.y) / mapMetaData.resolution);
+    unsigned int mx = std::floor((w_x - map_origin_x) / map_resolution);
+    unsigned int my = std::floor((w_y - map_origin_y) / map_resolution);
 
     return std::make_pair(mx, my);
 }
 
-void DistanceMap::SetMapMessage(const boost::shared_ptr<nav_msgs::OccupancyGrid const>& map_msg) {
+void DistanceMap::SetMap(const OccupancyGrid& grid, const Pose& pose) {
     if (!accepting_updates_) {
         return;
     }
 
-    try {
-        listener->waitForTransform(map_msg->header.frame_id, robot_base_frame, ros::Time(0), ros::Duration(.05));
-        listener->lookupTransform(map_msg->header.frame_id, robot_base_frame, ros::Time(0), transform);
-    } catch (tf::TransformException& ex) {
-        ROS_ERROR_STREAM(ex.what());
-    }
-
-    mapMetaData = map_msg->info;
+    robot_pose = pose;
+    map_width = grid.width;
+    map_height = grid.height;
+    map_resolution = grid.resolution;
+    map_origin_x = grid.origin_x;
+    map_origin_y = grid.origin_y;
 
     // Turn occupancy grid to distance map in meters
-    cv::Mat distance_map(mapMetaData.width, mapMetaData.height, CV_8UC1);
-    memcpy(distance_map.data, map_msg->data.data(), map_msg->data.size() * sizeof(uint8_t));
+    distance_map.create(map_width, map_height, CV_8UC1);
+    memcpy(distance_map.data, grid.data.data(), grid.data.size() * sizeof(uint8_t));
     cv::inRange(distance_map, 99, 254, distance_map);  // costmap2d::NO_INFORMATION is counted as FREE
     cv::bitwise_not(distance_map, distance_map);
 
     cv::distanceTransform(distance_map, distance_map, cv::DIST_L2, 3, CV_32F);
-    distance_map *= mapMetaData.resolution;
+    distance_map *= map_resolution;
 
     // Convert distance map to cost map based on: 100 * e^(-distance * cost_scaling_factor)
     cv::exp(-(distance_map - (wall_inflation + inscribed_circle_radius)) * cost_scaling_factor, distance_cost_map);
@@ -76,38 +73,6 @@ void DistanceMap::SetMapMessage(const boost::shared_ptr<nav_msgs::OccupancyGrid
     distance_cost_map.setTo(-1.0, distance_map <= wall_inflation + inscribed_circle_radius);
 
     updated_ = true;
-
-    if (publish_distance_map && distance_map_pub.getNumSubscribers() > 0) {
-        nav_msgs::OccupancyGrid occupancyGrid;
-        occupancyGrid.info = mapMetaData;
-        occupancyGrid.data = std::vector<int8_t>(mapMetaData.height * mapMetaData.width, 0);
-
-        cv::Mat distance_cost_map_int8;
-        distance_cost_map.convertTo(distance_cost_map_int8, CV_8SC1);
-        distance_cost_map_int8.setTo(-10, distance_map < wall_inflation + inscribed_circle_radius);
-        distance_cost_map_int8.setTo(-80, distance_map < wall_inflation);
-
-        occupancyGrid.data.assign(distance_cost_map_int8.data,
-                                  distance_cost_map_int8.data + distance_cost_map_int8.total());
-
-        distance_map_pub.publish(occupancyGrid);
-    }
-
-    if (publish_inscribed_circle && inscribed_circle_pub.getNumSubscribers() > 0) {
-        geometry_msgs::PolygonStamped circle;
-        circle.polygon.points = std::vector<geometry_msgs::Point32>(16);
-        circle.header.frame_id = map_msg->header.frame_id;
-        tf::Pose w_pose =
-              transform * tf::Pose(tf::createQuaternionFromYaw(0), tf::Vector3(inscribed_circle_origin, 0, 0));
-
-        for (unsigned int i = 0; i < circle.polygon.points.size(); i++) {
-            double angle = i * 2 * M_PI / circle.polygon.points.size();
-            circle.polygon.points[i].x = w_pose.getOrigin().x() + inscribed_circle_radius * cos(angle);
-            circle.polygon.points[i].y = w_pose.getOrigin().y() + inscribed_circle_radius * sin(angle);
-        }
-
-        inscribed_circle_pub.publish(circle);
-    }
 }
 
 }  // namespace rr
@@ -0,0 +1,79 @@
+#include <parameter_assertions/assertions.h>
+#include <rr_common/planning/distance_map_ros.h>
+#include <rr_common/planning/planner_metrics.h>
+#include <rr_common/planning/planning_ros.h>
+
+namespace rr {
+
+DistanceMapRos::DistanceMapRos(ros::NodeHandle nh)
+      : DistanceMap(LoadParams<DistanceMap::Params>(nh)), listener(new tf::TransformListener) {
+    std::string map_topic;
+    assertions::getParam(nh, "map_topic", map_topic);
+    assertions::getParam(nh, "robot_base_frame", robot_base_frame);
+    assertions::getParam(nh, "publish_distance_map", publish_distance_map);
+    assertions::getParam(nh, "publish_inscribed_circle", publish_inscribed_circle);
+
+    map_sub = nh.subscribe(map_topic, 1, &DistanceMapRos::SetMapMessage, this);
+    distance_map_pub = nh.advertise<nav_msgs::OccupancyGrid>("distance_map", 1);
+    inscribed_circle_pub = nh.advertise<geometry_msgs::PolygonStamped>("inscribed_circle", 1);
+}
+
+void DistanceMapRos::SetMapMessage(const nav_msgs::OccupancyGridConstPtr& map_msg) {
+    if (!accepting_updates_) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+        listener->waitForTransform(map_msg->header.frame_id, robot_base_frame, ros::Time(0), ros::Duration(.05));
+        listener->lookupTransform(map_msg->header.frame_id, robot_base_frame, ros::Time(0), transform);
+    } catch (tf::TransformException& ex) {
+        ROS_ERROR_STREAM(ex.what());
+    }
+
+    OccupancyGrid grid = FromOccupancyGridMsg(*map_msg);
+    map_ingest_ms_ = ElapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    SetMap(grid, FromTransform(transform));
+    map_preprocess_ms_ = ElapsedMs(start);
+    map_stamp_ = map_msg->header.stamp.toSec();
+
+    const double wall_inflation = GetWallInflation();
+    const double inscribed_circle_radius = GetInscribedCircleRadius();
+    const double inscribed_circle_origin = GetInscribedCircleOrigin();
+
+    if (publish_distance_map && distance_map_pub.getNumSubscribers() > 0) {
+        nav_msgs::OccupancyGrid occupancyGrid;
+        occupancyGrid.info = map_msg->info;
+        occupancyGrid.data = std::vector<int8_t>(map_msg->info.height * map_msg->info.width, 0);
+
+        cv::Mat distance_cost_map_int8;
+        GetDistanceCostMap().convertTo(distance_cost_map_int8, CV_8SC1);
+        distance_cost_map_int8.setTo(-10, GetDistanceMap() < wall_inflation + inscribed_circle_radius);
+        distance_cost_map_int8.setTo(-80, GetDistanceMap() < wall_inflation);
+
+        occupancyGrid.data.assign(distance_cost_map_int8.data,
+                                  distance_cost_map_int8.data + distance_cost_map_int8.total());
+
+        distance_map_pub.publish(occupancyGrid);
+    }
+
+    if (publish_inscribed_circle && inscribed_circle_pub.getNumSubscribers() > 0) {
+        geometry_msgs::PolygonStamped circle;
+        circle.polygon.points = std::vector<geometry_msgs::Point32>(16);
+        circle.header.frame_id = map_msg->header.frame_id;
+        tf::Pose w_pose =
+              transform * tf::Pose(tf::createQuaternionFromYaw(0), tf::Vector3(inscribed_circle_origin, 0, 0));
+
+        for (unsigned int i = 0; i < circle.polygon.points.size(); i++) {
+            double angle = i * 2 * M_PI / circle.polygon.points.size();
+            circle.polygon.points[i].x = w_pose.getOrigin().x() + inscribed_circle_radius * cos(angle);
+            circle.polygon.points[i].y = w_pose.getOrigin().y() + inscribed_circle_radius * sin(angle);
+        }
+
+        inscribed_circle_pub.publish(circle);
+    }
+}
+
+}  // namespace rr
@@ -0,0 +1,102 @@
+#include <rr_common/planning/flight_recorder.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace rr {
+
+namespace {
+
+constexpr char kMagic[4] = { 'R', 'R', 'F', 'R' };
+constexpr uint32_t kVersion = 2;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t count;
+};
+
+}  // namespace
+
+FlightRecorder::FlightRecorder(size_t capacity)
+      : slots_(new Slot[std::max<size_t>(capacity, 1)]), capacity_(std::max<size_t>(capacity, 1)), count_(0) {}
+
+void FlightRecorder::Record(const PlanRecord& record) {
+    const uint64_t index = count_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[index % capacity_];
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.record = record;
+    slot.sequence.store(2 * (index + 1), std::memory_order_release);
+
+    count_.store(index + 1, std::memory_order_release);
+}
+
+std::vector<PlanRecord> FlightRecorder::Snapshot() const {
+    const uint64_t count = count_.load(std::memory_order_acquire);
+    const uint64_t first = count > capacity_ ? count - capacity_ : 0;
+
+    std::vector<PlanRecord> records;
+    records.reserve(count - first);
+
+    for (uint64_t index = first; index < count; ++index) {
+        const Slot& slot = slots_[index % capacity_];
+
+        const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before != 2 * (index + 1)) {
+            continue;  // being written, or already holds a newer record
+        }
+        PlanRecord copy = slot.record;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before) {
+            continue;
+        }
+        records.push_back(copy);
+    }
+
+    return records;
+}
+
+size_t FlightRecorder::Dump(const std::string& path) const {
+    const std::vector<PlanRecord> records = Snapshot();
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.record_size = sizeof(PlanRecord);
+    header.count = static_cast<uint32_t>(records.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(PlanRecord));
+    if (!file) {
+        throw std::runtime_error("could not write flight recording " + path);
+    }
+    return records.size();
+}
+
+std::vector<PlanRecord> FlightRecorder::Load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    FileHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!file || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error(path + " is not a planner flight recording");
+    }
+    if (header.version != kVersion || header.record_size != sizeof(PlanRecord)) {
+        throw std::runtime_error(path + " was written by an incompatible planner version");
+    }
+
+    std::vector<PlanRecord> records(header.count);
+    file.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(PlanRecord));
+    if (!file) {
+        throw std::runtime_error(path + " is truncated");
+    }
+    return records;
+}
+
+}  // namespace rr
@@ -1,4 +1,3 @@
-#include <parameter_assertions/assertions.h>
 #include <rr_common/planning/hill_climb_optimizer.h>
 #include <rr_common/planning/planning_utils.h>
 
@@ -11,29 +10,18 @@ template class HillClimbOptimizer<1>;
 template class HillClimbOptimizer<2>;
 
 template <int ctrl_dim>
-HillClimbOptimizer<ctrl_dim>::HillClimbOptimizer(const ros::NodeHandle& nh) {
-    assertions::getParam(nh, "num_workers", num_workers_, { assertions::greater(0) });
-    assertions::getParam(nh, "num_restarts", num_restarts_, { assertions::greater(0) });
-    assertions::getParam(nh, "local_optimum_tries", local_optimum_tries_, { assertions::greater(0) });
-
-    std::vector<double> stddev;
-    assertions::getParam(nh, "neighbor_stddev", stddev, { assertions::size<std::vector<double>>(ctrl_dim) });
-
-    for (size_t i = 0; i < ctrl_dim; ++i) {
-        ROS_ASSERT(stddev[i] > 0);
-        neighbor_stddev_(i) = stddev[i];
-    }
-}
+HillClimbOptimizer<ctrl_dim>::HillClimbOptimizer(const Params& params) : params_(params), rand_gen_(1234567) {}
 
 template <int ctrl_dim>
 Controls<ctrl_dim> HillClimbOptimizer<ctrl_dim>::Optimize(const CostFunction<ctrl_dim>& cost_fn,
                                                           const Controls<ctrl_dim>& init_controls,
                                                           const Matrix<ctrl_dim, 2>& ctrl_limits) {
-    auto descend_hill = [this, &cost_fn, &ctrl_limits](Controls<ctrl_dim> controls) {
-        double best_cost = std::numeric_limits<double>::max();
-        int stuck_counter = local_optimum_tries_;
+    auto descend_hill = [this, &cost_fn, &ctrl_limits](Controls<ctrl_dim> controls, std::mt19937& rand_gen) {
+        real_t best_cost = std::numeric_limits<real_t>::max();
+        int stuck_counter = params_.local_optimum_tries;
         while (stuck_counter > 0) {
-            const Controls<ctrl_dim> new_controls = controls_neighbor(controls, ctrl_limits, neighbor_stddev_);
+            const Controls<ctrl_dim> new_controls =
+                  controls_neighbor(controls, ctrl_limits, params_.neighbor_stddev, rand_gen);
             auto cost = cost_fn(new_controls);
 
             if (cost >= best_cost) {
@@ -41,24 +29,31 @@ Controls<ctrl_dim> HillClimbOptimizer<ctrl_dim>::Optimize(const CostFunction<ctr
             } else {
                 controls = new_controls;
                 best_cost = cost;
-                stuck_counter = local_optimum_tries_;
+                stuck_counter = params_.local_optimum_tries;
             }
         }
         return std::make_tuple(best_cost, std::move(controls));
     };
 
     Controls<ctrl_dim> global_best_controls;
-    double global_best_cost = std::numeric_limits<double>::max();
+    real_t global_best_cost = std::numeric_limits<real_t>::max();
     int plan_count = 0;
     std::mutex plan_count_mutex, global_best_plan_mutex;
 
+    // drawn here, on the calling thread, so no generator is shared between threads
+    std::vector<std::mt19937> rand_gens;
+    for (int th_id = 0; th_id < params_.num_workers; ++th_id) {
+        rand_gens.emplace_back(rand_gen_());
+    }
+
     auto worker = [&, this](int thread_idx) {
+        std::mt19937& rand_gen = rand_gens[thread_idx];
         Controls<ctrl_dim> best_controls;
-        double best_cost = std::numeric_limits<double>::max();
+        real_t best_cost = std::numeric_limits<real_t>::max();
         while (true) {
             {
                 std::lock_guard lock(plan_count_mutex);
-                if (plan_count >= num_restarts_) {
+                if (plan_count >= params_.num_restarts) {
                     break;
                 }
                 plan_count++;
@@ -70,11 +65,11 @@ Controls<ctrl_dim> HillClimbOptimizer<ctrl_dim>::Optimize(const CostFunction<ctr
                 controls = init_controls;
             } else {
                 // select a random starting configuration
-                Vector<ctrl_dim> half_range = (ctrl_limits.col(1) - ctrl_limits.col(0)) * 0.5;
-                controls = rr::init_controls(init_controls.cols(), ctrl_limits, half_range);
+                Vector<ctrl_dim> half_range = (ctrl_limits.col(1) - ctrl_limits.col(0)) * real_t(0.5);
+                controls = rr::init_controls(init_controls.cols(), ctrl_limits, half_range, rand_gen);
             }
 
-            auto [cost, controls_opt] = descend_hill(controls);
+            auto [cost, controls_opt] = descend_hill(controls, rand_gen);
 
             if (cost < best_cost) {
                 best_controls = controls_opt;
@@ -90,7 +85,7 @@ Controls<ctrl_dim> HillClimbOptimizer<ctrl_dim>::Optimize(const CostFunction<ctr
     };
 
     std::vector<std::thread> threads;
-    for (int th_id = 0; th_id < num_workers_; ++th_id) {
+    for (int th_id = 0; th_id < params_.num_workers; ++th_id) {
         threads.emplace_back(worker, th_id);
     }
     for (auto& t : threads) {
@@ -0,0 +1,37 @@
+#include <parameter_assertions/assertions.h>
+#include <rr_common/planning/inflation_map_ros.h>
+#include <rr_common/planning/planner_metrics.h>
+#include <rr_common/planning/planning_ros.h>
+
+namespace rr {
+
+InflationMapRos::InflationMapRos(ros::NodeHandle nh)
+      : InflationMap(LoadParams<InflationMap::Params>(nh)), listener(new tf::TransformListener) {
+    std::string map_topic;
+    assertions::getParam(nh, "map_topic", map_topic);
+    map_sub = nh.subscribe(map_topic, 1, &InflationMapRos::SetMapMessage, this);
+}
+
+void InflationMapRos::SetMapMessage(const nav_msgs::OccupancyGridConstPtr& map_msg) {
+    if (!accepting_updates_) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+        listener->waitForTransform(map_msg->header.frame_id, "/base_footprint", ros::Time(0), ros::Duration(.05));
+        listener->lookupTransform(map_msg->header.frame_id, "/base_footprint", ros::Time(0), transform);
+    } catch (tf::TransformException& ex) {
+        ROS_ERROR_STREAM(ex.what());
+    }
+
+    OccupancyGrid grid = FromOccupancyGridMsg(*map_msg);
+    map_ingest_ms_ = ElapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    SetMap(grid, FromTransform(transform));
+    map_preprocess_ms_ = ElapsedMs(start);
+    map_stamp_ = map_msg->header.stamp.toSec();
+}
+
+}  // namespace rr
@@ -0,0 +1,337 @@
+#include <rr_common/planning/lattice_search_optimizer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+
+namespace rr {
+
+LatticeSearchOptimizer::LatticeSearchOptimizer(const Params& params, const MotionLattice& lattice,
+                                               MapCostInterface& map_cost, const CostWeights& weights,
+                                               const std::shared_ptr<rr::LinearTrackingFilter>& steer_model_ptr,
+                                               const std::shared_ptr<rr::LinearTrackingFilter>& speed_model_ptr,
+                                               std::unique_ptr<PlanningOptimizer<1>> local_optimizer)
+      : params_(params)
+      , lattice_(lattice)
+      , map_cost_(map_cost)
+      , weights_(weights)
+      , steering_model_(steer_model_ptr)
+      , speed_model_(speed_model_ptr)
+      , local_optimizer_(std::move(local_optimizer))
+      , cheapest_point_cost_(-1)
+      , cycle_(0)
+      , last_plan_time_(0)
+      , tree_time_(0) {
+    if (params_.reuse_stride > 0 && lattice_.GetNumPrimitives() > (1 << 20)) {
+        throw std::runtime_error("lattice search tree reuse supports at most 2^20 primitives");
+    }
+}
+
+uint64_t LatticeSearchOptimizer::PoseKey(real_t x, real_t y, real_t theta) const {
+    const auto ix = static_cast<int64_t>(std::floor(x / params_.xy_resolution));
+    const auto iy = static_cast<int64_t>(std::floor(y / params_.xy_resolution));
+    const real_t turns = theta / real_t(2 * M_PI);
+    const auto itheta = static_cast<int64_t>(std::floor((turns - std::floor(turns)) * params_.theta_bins));
+
+    // 16 bits each for x and y, 12 for heading
+    return (static_cast<uint64_t>(ix & 0xFFFF) << 28) | (static_cast<uint64_t>(iy & 0xFFFF) << 12) |
+           static_cast<uint64_t>(itheta & 0xFFF);
+}
+
+uint64_t LatticeSearchOptimizer::StateKey(const Node& node) const {
+    const auto isteer = static_cast<int64_t>(lattice_.NearestSteerBin(node.steer));
+
+    // pose, then 12 bits for steering and 8 for depth
+    return (PoseKey(node.x, node.y, node.theta) << 20) | (static_cast<uint64_t>(isteer & 0xFFF) << 8) |
+           static_cast<uint64_t>(node.depth & 0xFF);
+}
+
+int LatticeSearchOptimizer::RerootTree() {
+    const int segment_size = lattice_.GetSegmentSize();
+    const double now = steering_model_->GetLastUpdateTime();
+    const Path& path = last_rollout_.path;
+    const double elapsed = now - last_plan_time_;
+    if (path.size() < 2 || elapsed < 0 || elapsed > path.time.back()) {
+        tree_.clear();
+        tree_index_.clear();
+        tree_time_ = now;
+        return segment_size;
+    }
+
+    // the vehicle is assumed to have followed the previous plan since it was made
+    const double dt = path.time[1] - path.time[0];
+    const real_t steps = elapsed / dt;
+    const size_t i = std::min(static_cast<size_t>(steps), path.size() - 2);
+    const real_t f = steps - i;
+    const real_t x0 = path.x[i] + f * (path.x[i + 1] - path.x[i]);
+    const real_t y0 = path.y[i] + f * (path.y[i + 1] - path.y[i]);
+    const real_t theta0 = path.theta[i] + f * (path.theta[i + 1] - path.theta[i]);
+    const real_t cos_th = std::cos(theta0);
+    const real_t sin_th = std::sin(theta0);
+
+    // keep the edges the previous plan reached without colliding, in place
+    tree_index_.clear();
+    size_t kept = 0;
+    for (const TreeEdge& edge : tree_) {
+        if (edge.cycle != cycle_ || edge.map_cost < 0) {
+            continue;
+        }
+        TreeEdge moved = edge;
+        moved.x = (edge.x - x0) * cos_th + (edge.y - y0) * sin_th;
+        moved.y = -(edge.x - x0) * sin_th + (edge.y - y0) * cos_th;
+        moved.theta = edge.theta - theta0;
+        const uint64_t key = (PoseKey(moved.x, moved.y, moved.theta) << 20) | static_cast<uint64_t>(moved.primitive);
+        if (tree_index_.try_emplace(key, static_cast<int>(kept)).second) {
+            tree_[kept++] = moved;
+        }
+    }
+    tree_.resize(kept);
+
+    // searching at the tree's segment times finds the subtree of the branch being driven again
+    const auto phase = static_cast<int>(std::lround((now - tree_time_) / dt) % segment_size);
+    return segment_size - phase;
+}
+
+real_t LatticeSearchOptimizer::PrimitiveMapCost(const Node& start, int primitive,
+                                                const MotionLattice::PrimitivePoint* points, int size) {
+    const int stride = size == lattice_.GetSegmentSize() ? params_.reuse_stride : 0;
+    const real_t cos_th = std::cos(start.theta);
+    const real_t sin_th = std::sin(start.theta);
+    auto point_cost = [&](int k) {
+        const MotionLattice::PrimitivePoint& p = points[k];
+        return map_cost_.DistanceCost(Pose(start.x + p.x * cos_th - p.y * sin_th,
+                                           start.y + p.x * sin_th + p.y * cos_th, start.theta + p.theta));
+    };
+
+    TreeEdge* edge = nullptr;
+    if (stride > 0) {
+        const uint64_t key = (PoseKey(start.x, start.y, start.theta) << 20) | static_cast<uint64_t>(primitive);
+        auto [it, inserted] = tree_index_.try_emplace(key, static_cast<int>(tree_.size()));
+        if (inserted) {
+            tree_.push_back({ start.x, start.y, start.theta, primitive, 0, 0, -1 });
+        }
+        edge = &tree_[it->second];
+
+        // the bin is only the key: another start pose in it may hit an obstacle the cached one clears
+        const bool same_start = std::abs(edge->x - start.x) <= kSameStartTolerance &&
+                                std::abs(edge->y - start.y) <= kSameStartTolerance &&
+                                std::abs(std::remainder(edge->theta - start.theta, real_t(2 * M_PI))) <=
+                                      kSameStartTolerance;
+        if (same_start && edge->cycle == cycle_) {
+            return edge->map_cost;  // already evaluated for this map
+        }
+
+        if (same_start && !inserted) {
+            // kept from the previous plan: re-check the last point of every stride against the new map
+            real_t sampled_cost = 0;
+            bool valid = true;
+            for (int k = size - 1; k >= 0 && valid; k -= stride) {
+                const real_t cost = point_cost(k);
+                valid = cost >= 0;
+                sampled_cost += discount_[k + 1] * cost;
+            }
+            if (valid && std::abs(sampled_cost - edge->sampled_cost) <= params_.reuse_tolerance * edge->sampled_cost) {
+                edge->cycle = cycle_;
+                return edge->map_cost;
+            }
+        }
+    }
+
+    real_t map_cost = 0;
+    real_t sampled_cost = 0;
+    for (int k = 0; k < size; ++k) {
+        const real_t cost = point_cost(k);
+        if (cost < 0) {
+            map_cost = -1;
+            break;
+        }
+        map_cost += discount_[k + 1] * cost;
+        if (stride > 0 && (size - 1 - k) % stride == 0) {
+            sampled_cost += discount_[k + 1] * cost;
+        }
+    }
+
+    if (edge) {
+        *edge = { start.x, start.y, start.theta, primitive, map_cost, sampled_cost, cycle_ };
+    }
+    return map_cost;
+}
+
+Controls<1> LatticeSearchOptimizer::Optimize(const CostFunction<1>& cost_fn, const Controls<1>& init_controls,
+                                             const Matrix<1, 2>& ctrl_limits) {
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double, std::milli>(params_.deadline_ms));
+    const int n_segments = init_controls.cols();
+    const int segment_size = lattice_.GetSegmentSize();
+
+    const size_t path_size = 1 + static_cast<size_t>(n_segments + 1) * segment_size;
+    if (discount_.size() < path_size) {
+        discount_.resize(path_size);
+        for (size_t i = 0; i < path_size; ++i) {
+            discount_[i] = std::pow(kTrajectoryCostDiscount, -static_cast<real_t>(i));
+        }
+    }
+
+    const int first_size = params_.reuse_stride > 0 ? RerootTree() : segment_size;
+    const int n_levels = first_size < segment_size ? n_segments + 1 : n_segments;  // to cover the whole horizon
+    ++cycle_;
+
+    Controls<1> best_controls = init_controls;
+    real_t best_g = std::numeric_limits<real_t>::max();
+    std::vector<Node> nodes;
+    cheapest_point_cost_ = -1;
+
+    for (real_t epsilon = params_.epsilon_start;; epsilon = std::max<real_t>(1, epsilon - params_.epsilon_step)) {
+        nodes.clear();
+        const int goal = Search(n_levels, first_size, epsilon, deadline, nodes);
+        if (goal >= 0 && nodes[goal].g < best_g) {
+            best_g = nodes[goal].g;
+            std::vector<real_t> chain(n_levels);
+            for (int i = goal; nodes[i].parent >= 0; i = nodes[i].parent) {
+                chain[nodes[i].depth - 1] = lattice_.GetControl(nodes[i].control_bin);
+            }
+            // back to whole segments from now, each taking the primitive in effect at its middle
+            for (int i = 0; i < n_segments; ++i) {
+                const int middle = i * segment_size + segment_size / 2;
+                best_controls(i) =
+                      chain[middle < first_size ? 0 : std::min(n_levels - 1, 1 + (middle - first_size) / segment_size)];
+            }
+        }
+        if (epsilon <= 1 || std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+    }
+
+    for (int i = 0; i < best_controls.cols(); ++i) {
+        best_controls(i) = std::clamp(best_controls(i), ctrl_limits(0, 0), ctrl_limits(0, 1));
+    }
+    if (cost_fn(init_controls) < cost_fn(best_controls)) {
+        best_controls = init_controls;
+    }
+
+    if (local_optimizer_) {
+        best_controls = local_optimizer_->Optimize(cost_fn, best_controls, ctrl_limits);
+    }
+    if (params_.reuse_stride > 0) {
+        lattice_.RollOutPath(best_controls, last_rollout_);
+        last_plan_time_ = steering_model_->GetLastUpdateTime();
+    }
+    return best_controls;
+}
+
+int LatticeSearchOptimizer::Search(int n_segments, int first_size, real_t epsilon,
+                                   std::chrono::steady_clock::time_point deadline, std::vector<Node>& nodes) {
+    const int segment_size = lattice_.GetSegmentSize();
+    const int num_controls = std::clamp(params_.num_controls, 2, lattice_.GetNumControls());
+    const real_t max_speed = speed_model_->GetValMax();
+
+    // path index of the end of the primitive leading to a depth
+    auto path_index = [&](int depth) { return depth == 0 ? 0 : first_size + (depth - 1) * segment_size; };
+
+    // discounted weight of the path points still to come at each depth
+    std::vector<real_t> remaining_weight(n_segments + 1, 0);
+    for (int depth = n_segments - 1; depth >= 0; --depth) {
+        remaining_weight[depth] = remaining_weight[depth + 1];
+        for (int i = path_index(depth) + 1; i <= path_index(depth + 1); ++i) {
+            remaining_weight[depth] += discount_[i];
+        }
+    }
+
+    // append the successor of a node along one primitive, unless it collides
+    auto expand = [&](int parent, int control_bin) {
+        const Node& node = nodes[parent];
+        const int speed_bin = lattice_.NearestSpeedBin(node.speed);
+        const int steer_bin = lattice_.NearestSteerBin(node.steer);
+        const MotionLattice::PrimitivePoint* p = lattice_.GetPrimitive(speed_bin, steer_bin, control_bin);
+        const int size = node.depth == 0 ? first_size : segment_size;
+        const real_t map_cost =
+              PrimitiveMapCost(node, lattice_.PrimitiveIndex(speed_bin, steer_bin, control_bin), p, size);
+        if (map_cost < 0) {
+            return false;
+        }
+
+        // the map term's discount is relative to the primitive's start
+        const int base = path_index(node.depth);
+        real_t g = node.g + discount_[base] * weights_.k_map_cost * map_cost;
+        for (int k = 0; k < size; ++k) {
+            g += discount_[base + k + 1] *
+                 (weights_.k_speed * std::pow(max_speed - p[k].speed, 2) + weights_.k_steering * std::abs(p[k].steer) +
+                  weights_.k_angle * std::abs(node.theta + p[k].theta));
+        }
+
+        const MotionLattice::PrimitivePoint& end = p[size - 1];
+        const real_t cos_th = std::cos(node.theta);
+        const real_t sin_th = std::sin(node.theta);
+        nodes.push_back({ node.x + end.x * cos_th - end.y * sin_th, node.y + end.x * sin_th + end.y * cos_th,
+                          node.theta + end.theta, end.steer, end.speed, g, node.depth + 1, parent, control_bin });
+        return true;
+    };
+
+    auto control_bin = [&](int i) {
+        return static_cast<int>(std::lround(real_t(i) * (lattice_.GetNumControls() - 1) / (num_controls - 1)));
+    };
+
+    nodes.push_back({ 0, 0, 0, static_cast<real_t>(steering_model_->GetValue()),
+                      static_cast<real_t>(speed_model_->GetValue()), 0, 0, -1, -1 });
+
+    if (cheapest_point_cost_ < 0) {
+        // per-point cost of the cheapest first step, as an estimate for later steps. Not a lower bound: they can be
+        // cheaper, e.g. once the vehicle is faster, so the weight only trades search time against plan cost
+        cheapest_point_cost_ = std::numeric_limits<real_t>::max();
+        for (int i = 0; i < num_controls; ++i) {
+            if (expand(0, control_bin(i))) {
+                const real_t point_cost = nodes.back().g / (remaining_weight[0] - remaining_weight[1]);
+                cheapest_point_cost_ = std::min(cheapest_point_cost_, point_cost);
+                nodes.pop_back();
+            }
+        }
+        if (cheapest_point_cost_ == std::numeric_limits<real_t>::max()) {
+            return -1;  // every first step collides
+        }
+    }
+
+    using Entry = std::pair<real_t, int>;  // (f, node index)
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> open;
+    std::unordered_map<uint64_t, real_t> best_g;
+
+    open.emplace(epsilon * cheapest_point_cost_ * remaining_weight[0], 0);
+    best_g[StateKey(nodes[0])] = 0;
+
+    int expansions = 0;
+    while (!open.empty()) {
+        const int index = open.top().second;
+        open.pop();
+
+        if (nodes[index].g > best_g[StateKey(nodes[index])]) {
+            continue;  // superseded by a cheaper path to the same state
+        }
+        if (nodes[index].depth == n_segments) {
+            return index;
+        }
+        if (++expansions > params_.max_expansions ||
+            (expansions % 32 == 0 && std::chrono::steady_clock::now() >= deadline)) {
+            return -1;
+        }
+
+        for (int i = 0; i < num_controls; ++i) {
+            if (!expand(index, control_bin(i))) {
+                continue;
+            }
+            const Node& child = nodes.back();
+            auto [it, inserted] = best_g.try_emplace(StateKey(child), child.g);
+            if (!inserted && child.g >= it->second) {
+                nodes.pop_back();
+                continue;
+            }
+            it->second = child.g;
+            open.emplace(child.g + epsilon * cheapest_point_cost_ * remaining_weight[child.depth],
+                         static_cast<int>(nodes.size() - 1));
+        }
+    }
+    return -1;
+}
+
+}  // namespace rr
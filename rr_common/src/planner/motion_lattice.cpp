@@ -0,0 +1,302 @@
+#include <fcntl.h>
+#include <rr_common/planning/motion_lattice.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace rr {
+
+namespace {
+
+constexpr char kMagic[4] = { 'R', 'R', 'M', 'L' };
+constexpr uint32_t kVersion = 2;
+
+struct GridPosition {
+    int bin;          // lower of the two surrounding grid points
+    real_t fraction;  // position between them, in [0, 1]
+};
+
+/**
+ * Grid points surrounding a value, clamped to the grid
+ */
+inline GridPosition Locate(real_t value, real_t min, real_t scale, int size) {
+    const real_t index = std::clamp((value - min) * scale, real_t(0), real_t(size - 1));
+    const int bin = std::min(static_cast<int>(index), size - 2);
+    return { bin, index - bin };
+}
+
+inline bool SameParam(double a, double b) {
+    return std::abs(a - b) <= 1e-9 * std::max(1.0, std::abs(a));
+}
+
+}  // namespace
+
+struct MotionLattice::FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t speed_bins;
+    uint32_t steer_bins;
+    uint32_t control_bins;
+    uint32_t segment_size;
+
+    // generation inputs, checked against the planner's configuration on load
+    double dt;
+    double wheel_base;
+    double lateral_accel;
+    double steer_min, steer_max, steer_rate_min, steer_rate_max;
+    double speed_min, speed_max, speed_rate_min, speed_rate_max;
+
+    // followed by segment_size PrimitivePoints per primitive
+};
+
+void MotionLattice::Generate(const std::string& path, const Params& params, const BicycleModel::Params& model_params,
+                             const LinearTrackingFilter::Params& steer_params,
+                             const LinearTrackingFilter::Params& speed_params) {
+    if (params.speed_bins < 2 || params.steer_bins < 2 || params.control_bins < 2) {
+        throw std::runtime_error("motion lattice grids need at least two points each");
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.speed_bins = params.speed_bins;
+    header.steer_bins = params.steer_bins;
+    header.control_bins = params.control_bins;
+    header.segment_size = model_params.segment_size;
+    header.dt = model_params.dt;
+    header.wheel_base = model_params.wheel_base;
+    header.lateral_accel = model_params.lateral_accel;
+    header.steer_min = steer_params.val_min;
+    header.steer_max = steer_params.val_max;
+    header.steer_rate_min = steer_params.rate_min;
+    header.steer_rate_max = steer_params.rate_max;
+    header.speed_min = speed_params.val_min;
+    header.speed_max = speed_params.val_max;
+    header.speed_rate_min = speed_params.rate_min;
+    header.speed_rate_max = speed_params.rate_max;
+
+    auto steer_model = std::make_shared<LinearTrackingFilter>(steer_params);
+    auto speed_model = std::make_shared<LinearTrackingFilter>(speed_params);
+    BicycleModel::Params exact_params = model_params;
+    exact_params.lookup_table_size = 0;
+    BicycleModel model(exact_params, steer_model, speed_model);
+
+    const int n_primitives = params.speed_bins * params.steer_bins * params.control_bins;
+    std::vector<PrimitivePoint> points;
+    points.reserve(static_cast<size_t>(n_primitives) * model_params.segment_size);
+
+    auto grid_value = [](double min, double max, int i, int size) { return min + (max - min) * i / (size - 1); };
+
+    Controls<1> control(1, 1);
+    TrajectoryRollout rollout;
+    for (int vi = 0; vi < params.speed_bins; ++vi) {
+        for (int si = 0; si < params.steer_bins; ++si) {
+            for (int ci = 0; ci < params.control_bins; ++ci) {
+                speed_model->Reset(grid_value(speed_params.val_min, speed_params.val_max, vi, params.speed_bins), 0);
+                steer_model->Reset(grid_value(steer_params.val_min, steer_params.val_max, si, params.steer_bins), 0);
+                control(0) = grid_value(steer_params.val_min, steer_params.val_max, ci, params.control_bins);
+                model.RollOutPath(control, rollout);
+                const Path& p = rollout.path;
+
+                for (size_t i = 1; i < p.size(); ++i) {
+                    points.push_back({ static_cast<float>(p.x[i]), static_cast<float>(p.y[i]),
+                                       static_cast<float>(p.theta[i]), static_cast<float>(p.steer[i]),
+                                       static_cast<float>(p.speed[i]) });
+                }
+            }
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(PrimitivePoint));
+    if (!file) {
+        throw std::runtime_error("could not write motion lattice " + path);
+    }
+}
+
+MotionLattice::MotionLattice(const std::string& path, const BicycleModel::Params& model_params,
+                             const std::shared_ptr<rr::LinearTrackingFilter>& steer_model_ptr,
+                             const std::shared_ptr<rr::LinearTrackingFilter>& speed_model_ptr)
+      : mapping_(MAP_FAILED)
+      , mapping_size_(0)
+      , header_(nullptr)
+      , points_(nullptr)
+      , steering_model_(steer_model_ptr)
+      , speed_model_(speed_model_ptr) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("could not open motion lattice " + path);
+    }
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) == 0 && static_cast<size_t>(file_stat.st_size) >= sizeof(FileHeader)) {
+        mapping_size_ = file_stat.st_size;
+        mapping_ = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);  // the mapping keeps the file referenced
+    if (mapping_ == MAP_FAILED) {
+        throw std::runtime_error(path + " is not a motion lattice");
+    }
+
+    header_ = static_cast<const FileHeader*>(mapping_);
+    if (std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0 || header_->version != kVersion) {
+        munmap(mapping_, mapping_size_);
+        throw std::runtime_error(path + " is not a compatible motion lattice");
+    }
+
+    const size_t n_primitives = GetNumPrimitives();
+    const size_t expected_size = sizeof(FileHeader) + n_primitives * header_->segment_size * sizeof(PrimitivePoint);
+    if (mapping_size_ != expected_size) {
+        munmap(mapping_, mapping_size_);
+        throw std::runtime_error(path + " is truncated");
+    }
+
+    const bool matches = static_cast<int>(header_->segment_size) == model_params.segment_size &&
+                         SameParam(header_->dt, model_params.dt) &&
+                         SameParam(header_->wheel_base, model_params.wheel_base) &&
+                         SameParam(header_->lateral_accel, model_params.lateral_accel) &&
+                         SameParam(header_->steer_min, steer_model_ptr->GetValMin()) &&
+                         SameParam(header_->steer_max, steer_model_ptr->GetValMax()) &&
+                         SameParam(header_->steer_rate_min, steer_model_ptr->GetRateMin()) &&
+                         SameParam(header_->steer_rate_max, steer_model_ptr->GetRateMax()) &&
+                         SameParam(header_->speed_min, speed_model_ptr->GetValMin()) &&
+                         SameParam(header_->speed_max, speed_model_ptr->GetValMax()) &&
+                         SameParam(header_->speed_rate_min, speed_model_ptr->GetRateMin()) &&
+                         SameParam(header_->speed_rate_max, speed_model_ptr->GetRateMax());
+    if (!matches) {
+        munmap(mapping_, mapping_size_);
+        throw std::runtime_error(path + " was generated for a different vehicle model or filter limits");
+    }
+
+    points_ = reinterpret_cast<const PrimitivePoint*>(header_ + 1);
+
+    speed_min_ = header_->speed_min;
+    speed_scale_ = (header_->speed_bins - 1) / (header_->speed_max - header_->speed_min);
+    steer_min_ = header_->steer_min;
+    steer_scale_ = (header_->steer_bins - 1) / (header_->steer_max - header_->steer_min);
+    control_scale_ = (header_->control_bins - 1) / (header_->steer_max - header_->steer_min);
+}
+
+MotionLattice::~MotionLattice() {
+    munmap(mapping_, mapping_size_);
+}
+
+int MotionLattice::GetSegmentSize() const {
+    return header_->segment_size;
+}
+
+int MotionLattice::GetNumPrimitives() const {
+    return header_->speed_bins * header_->steer_bins * header_->control_bins;
+}
+
+int MotionLattice::GetNumControls() const {
+    return header_->control_bins;
+}
+
+real_t MotionLattice::GetControl(int control_bin) const {
+    return steer_min_ + control_bin / control_scale_;
+}
+
+int MotionLattice::NearestSpeedBin(real_t speed) const {
+    const auto bin = static_cast<int>(std::lround((speed - speed_min_) * speed_scale_));
+    return std::clamp(bin, 0, static_cast<int>(header_->speed_bins) - 1);
+}
+
+int MotionLattice::NearestSteerBin(real_t steer) const {
+    const auto bin = static_cast<int>(std::lround((steer - steer_min_) * steer_scale_));
+    return std::clamp(bin, 0, static_cast<int>(header_->steer_bins) - 1);
+}
+
+int MotionLattice::PrimitiveIndex(int speed_bin, int steer_bin, int control_bin) const {
+    return (speed_bin * header_->steer_bins + steer_bin) * header_->control_bins + control_bin;
+}
+
+const MotionLattice::PrimitivePoint* MotionLattice::GetPrimitive(int speed_bin, int steer_bin,
+                                                                 int control_bin) const {
+    return points_ + static_cast<size_t>(PrimitiveIndex(speed_bin, steer_bin, control_bin)) * header_->segment_size;
+}
+
+void MotionLattice::RollOutPath(const Controls<1>& controls, TrajectoryRollout& rollout) const {
+    const int segment_size = header_->segment_size;
+    const real_t dt = header_->dt;
+
+    const size_t path_size = 1 + (segment_size * controls.cols());
+    Path& path = rollout.path;
+    if (path.size() != path_size) {
+        path.resize(path_size);
+    }
+
+    path.x[0] = 0;
+    path.y[0] = 0;
+    path.theta[0] = 0;
+    path.speed[0] = speed_model_->GetValue();
+    path.steer[0] = steering_model_->GetValue();
+    path.time[0] = 0;
+
+    rollout.apply_steering = controls(0);
+
+    size_t i = 1;
+    for (int segment = 0; segment < controls.cols(); segment++) {
+        const GridPosition v = Locate(path.speed[i - 1], speed_min_, speed_scale_, header_->speed_bins);
+        const GridPosition s = Locate(path.steer[i - 1], steer_min_, steer_scale_, header_->steer_bins);
+        const GridPosition c = Locate(controls(segment), steer_min_, control_scale_, header_->control_bins);
+
+        // trilinear blend of the eight surrounding primitives, accumulated in the start frame of the segment
+        std::fill_n(&path.x[i], segment_size, 0);
+        std::fill_n(&path.y[i], segment_size, 0);
+        std::fill_n(&path.theta[i], segment_size, 0);
+        std::fill_n(&path.steer[i], segment_size, 0);
+        std::fill_n(&path.speed[i], segment_size, 0);
+        for (int corner = 0; corner < 8; ++corner) {
+            const real_t weight = ((corner & 4) ? v.fraction : 1 - v.fraction) *
+                                  ((corner & 2) ? s.fraction : 1 - s.fraction) *
+                                  ((corner & 1) ? c.fraction : 1 - c.fraction);
+            if (weight == 0) {
+                continue;
+            }
+            const PrimitivePoint* p = GetPrimitive(v.bin + ((corner >> 2) & 1), s.bin + ((corner >> 1) & 1),
+                                                   c.bin + (corner & 1));
+            for (int k = 0; k < segment_size; ++k) {
+                path.x[i + k] += weight * p[k].x;
+                path.y[i + k] += weight * p[k].y;
+                path.theta[i + k] += weight * p[k].theta;
+                path.steer[i + k] += weight * p[k].steer;
+                path.speed[i + k] += weight * p[k].speed;
+            }
+        }
+
+        const real_t x0 = path.x[i - 1];
+        const real_t y0 = path.y[i - 1];
+        const real_t theta0 = path.theta[i - 1];
+        const real_t cos_th = std::cos(theta0);
+        const real_t sin_th = std::sin(theta0);
+        for (size_t j = i; j < i + segment_size; ++j) {
+            const real_t x = path.x[j];
+            const real_t y = path.y[j];
+            path.x[j] = x0 + x * cos_th - y * sin_th;
+            path.y[j] = y0 + x * sin_th + y * cos_th;
+            path.theta[j] += theta0;
+            path.time[j] = path.time[j - 1] + dt;
+        }
+
+        i += segment_size;
+    }
+
+    rr::LinearTrackingFilter speed_model_temp = *speed_model_;
+    speed_model_temp.Reset(path.speed.back(), 0);
+    for (i = path_size - 1; i >= 1; --i) {
+        speed_model_temp.SetTarget(path.speed[i]);
+        speed_model_temp.UpdateRawDT(-dt);
+        path.speed[i - 1] = std::min<real_t>(path.speed[i - 1], speed_model_temp.GetValue());
+    }
+    rollout.apply_speed = speed_model_temp.GetValue();
+}
+
+}  // namespace rr
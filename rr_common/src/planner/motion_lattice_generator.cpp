@@ -0,0 +1,48 @@
+/**
+ * Offline motion lattice generation: enumerates the single-segment BicycleModel rollouts of a planner configuration
+ * and writes them to a lattice file that planner_node memory-maps at startup.
+ *
+ * Usage: motion_lattice_generator <planner_config.yaml> <output.bin>
+ *
+ * The config is a planner parameter file such as rr_evgp/conf/planner_sim.yaml. Grid sizes come from its
+ * motion_lattice section. Regenerate the file whenever the bicycle_model or filter parameters change; the planner
+ * refuses a lattice that doesn't match them.
+ */
+
+#include <rr_common/planning/motion_lattice.h>
+#include <rr_common/planning/yaml_params.h>
+
+#include <chrono>
+#include <iostream>
+#include <rr_common/linear_tracking_filter.hpp>
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <planner_config.yaml> <output.bin>" << std::endl;
+        return 1;
+    }
+
+    try {
+        const YAML::Node yaml = YAML::LoadFile(argv[1]);
+
+        const rr::BicycleModel::Params model_params = rr::LoadBicycleModel(yaml["bicycle_model"]);
+
+        const auto lattice_node = yaml["motion_lattice"];
+        rr::MotionLattice::Params params{ rr::YamlParam<int>(lattice_node, "speed_bins"),
+                                          rr::YamlParam<int>(lattice_node, "steer_bins"),
+                                          rr::YamlParam<int>(lattice_node, "control_bins") };
+
+        auto start = std::chrono::steady_clock::now();
+        rr::MotionLattice::Generate(argv[2], params, model_params, rr::LoadFilter(yaml["steering_filter"]),
+                                    rr::LoadFilter(yaml["speed_filter"]));
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << "Wrote " << params.speed_bins * params.steer_bins * params.control_bins << " primitives of "
+                  << model_params.segment_size << " points to " << argv[2] << " in " << elapsed.count() << " s"
+                  << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
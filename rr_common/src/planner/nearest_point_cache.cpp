@@ -1,15 +1,16 @@
-#include <parameter_assertions/assertions.h>
-#include <pcl_conversions/pcl_conversions.h>
 #include <rr_common/planning/nearest_point_cache.h>
 
 #include <functional>
+#include <iostream>
 
 namespace rr {
 
-NearestPointCache::NearestPointCache(ros::NodeHandle nh)
-      : points_storage_(), map_limits_(ros::NodeHandle(nh, "map_limits")), hitbox_(ros::NodeHandle(nh, "hitbox")) {
-    assertions::getParam(nh, "cache_resolution", cache_resolution_, { assertions::greater(0.0) });
-
+NearestPointCache::NearestPointCache(const Params& params)
+      : points_storage_()
+      , cache_resolution_(params.cache_resolution)
+      , map_limits_(params.map_limits)
+      , dist_decay_(params.distance_decay_factor)
+      , hitbox_(params.hitbox) {
     cache_size_x_ = static_cast<int>((map_limits_.max_x - map_limits_.min_x) / cache_resolution_);
     cache_size_y_ = static_cast<int>((map_limits_.max_y - map_limits_.min_y) / cache_resolution_);
 
@@ -26,12 +27,6 @@ NearestPointCache::NearestPointCache(ros::NodeHandle nh)
     double half_x = (hitbox_.max_x - hitbox_.min_x) / 2.;
     double half_y = (hitbox_.max_y - hitbox_.min_y) / 2.;
     hitbox_corner_dist_ = std::sqrt(half_x * half_x + half_y * half_y);
-
-    std::string obstacle_cloud_topic;
-    assertions::getParam(nh, "input_cloud_topic", obstacle_cloud_topic);
-    map_sub_ = nh.subscribe(obstacle_cloud_topic, 1, &NearestPointCache::SetMapMessage, this);
-
-    assertions::getParam(nh, "distance_decay_factor", dist_decay_, { assertions::greater(0.0) });
 }
 
 inline double dist(const NearestPointCache::point_t& p1, const NearestPointCache::point_t& p2) {
@@ -40,20 +35,19 @@ inline double dist(const NearestPointCache::point_t& p1, const NearestPointCache
     return std::sqrt(dx * dx + dy * dy);
 }
 
-void NearestPointCache::SetMapMessage(const sensor_msgs::PointCloud2ConstPtr& cloud_msg) {
+void NearestPointCache::SetMap(pcl::PointCloud<point_t> cloud) {
     if (!accepting_updates_) {
         return;
     }
 
-    points_storage_.clear();
-    pcl::fromROSMsg(*cloud_msg, points_storage_);
+    points_storage_ = std::move(cloud);
 
     // remove points in collision with robot
     std::remove_if(points_storage_.begin(), points_storage_.end(),
                    [this](const auto& point) { return hitbox_.PointInside(point.x, point.y); });
 
     if (points_storage_.empty()) {
-        ROS_WARN("environment map pointcloud is empty");
+        std::cerr << "[NearestPointCache] environment map pointcloud is empty" << std::endl;
     }
 
     for (CacheEntry& v : cache_) {
@@ -136,17 +130,17 @@ void NearestPointCache::SetMapMessage(const sensor_msgs::PointCloud2ConstPtr& cl
     updated_ = true;
 }
 
-double NearestPointCache::DistanceCost(const rr::Pose& pose) {
-    double cos_th = std::cos(pose.theta);
-    double sin_th = std::sin(pose.theta);
+real_t NearestPointCache::DistanceCost(const rr::Pose& pose) {
+    real_t cos_th = std::cos(pose.theta);
+    real_t sin_th = std::sin(pose.theta);
 
-    double center_x = (hitbox_.min_x + hitbox_.max_x) / 2.;
-    double center_y = (hitbox_.min_y + hitbox_.max_y) / 2.;
-    double search_x = pose.x + center_x * cos_th - center_y * sin_th;
-    double search_y = pose.y + center_x * sin_th + center_y * cos_th;
+    real_t center_x = (hitbox_.min_x + hitbox_.max_x) / 2.;
+    real_t center_y = (hitbox_.min_y + hitbox_.max_y) / 2.;
+    real_t search_x = pose.x + center_x * cos_th - center_y * sin_th;
+    real_t search_y = pose.y + center_x * sin_th + center_y * cos_th;
 
-    double half_x = (hitbox_.max_x - hitbox_.min_x) / 2.;
-    double half_y = (hitbox_.max_y - hitbox_.min_y) / 2.;
+    real_t half_x = (hitbox_.max_x - hitbox_.min_x) / 2.;
+    real_t half_y = (hitbox_.max_y - hitbox_.min_y) / 2.;
 
     int i = GetCacheIndex(pose.x, pose.y);
     if (i < 0) {
@@ -155,16 +149,16 @@ double NearestPointCache::DistanceCost(const rr::Pose& pose) {
 
     const CacheEntry& entry = cache_[i];
 
-    auto point_in_local_frame = [search_x, search_y, cos_th, sin_th](const point_t& p, double& x, double& y) {
-        double offsetX = p.x - search_x;
-        double offsetY = p.y - search_y;
+    auto point_in_local_frame = [search_x, search_y, cos_th, sin_th](const point_t& p, real_t& x, real_t& y) {
+        real_t offsetX = p.x - search_x;
+        real_t offsetY = p.y - search_y;
         x = cos_th * offsetX + sin_th * offsetY;
         y = -sin_th * offsetX + cos_th * offsetY;
     };
 
     // collisions
     for (const point_t* p_ptr : entry.might_hit_points) {
-        double x, y;
+        real_t x, y;
         point_in_local_frame(*p_ptr, x, y);
         if (std::abs(x) <= half_x && std::abs(y) <= half_y) {
             return -1.0;
@@ -172,20 +166,20 @@ double NearestPointCache::DistanceCost(const rr::Pose& pose) {
     }
 
     // find distance, in several cases
-    double dist;
+    real_t dist;
     if (nullptr == entry.nearest_point) {  // empty map (?)
         dist = std::pow(10.0, 10);
     } else {
-        double x, y;
+        real_t x, y;
         point_in_local_frame(*entry.nearest_point, x, y);
         if (std::abs(x) > half_x) {
             // not alongside the robot
             if (std::abs(y) > half_y) {
                 // closest to a corner
-                double cornerX = half_x * ((x < 0) ? -1 : 1);
-                double cornerY = half_y * ((y < 0) ? -1 : 1);
-                double dx = x - cornerX;
-                double dy = y - cornerY;
+                real_t cornerX = half_x * ((x < 0) ? -1 : 1);
+                real_t cornerY = half_y * ((y < 0) ? -1 : 1);
+                real_t dx = x - cornerX;
+                real_t dy = y - cornerY;
                 dist = std::sqrt(dx * dx + dy * dy);
             } else {
                 // directly in front of or behind robot
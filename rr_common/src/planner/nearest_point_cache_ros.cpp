@@ -0,0 +1,33 @@
+#include <parameter_assertions/assertions.h>
+#include <rr_common/planning/nearest_point_cache_ros.h>
+#include <rr_common/planning/planner_metrics.h>
+#include <rr_common/planning/planning_ros.h>
+
+namespace rr {
+
+NearestPointCacheRos::NearestPointCacheRos(ros::NodeHandle nh)
+      : NearestPointCache(LoadParams<NearestPointCache::Params>(nh)) {
+    std::string obstacle_cloud_topic;
+    assertions::getParam(nh, "input_cloud_topic", obstacle_cloud_topic);
+    map_sub_.Subscribe(nh, obstacle_cloud_topic, [this](const ObstaclePoints& points) { SetMapMessage(points); });
+}
+
+void NearestPointCacheRos::SetMapMessage(const ObstaclePoints& points) {
+    if (!accepting_updates_) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    // one pass straight from the message buffer into the storage the cache will point into
+    pcl::PointCloud<point_t> cloud;
+    cloud.reserve(points.size());
+    points.ForEach([&cloud](float x, float y) { cloud.push_back(point_t(x, y, 0)); });
+    map_ingest_ms_ = ElapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    SetMap(std::move(cloud));
+    map_preprocess_ms_ = ElapsedMs(start);
+    map_stamp_ = points.header().stamp.toSec();
+}
+
+}  // namespace rr
@@ -0,0 +1,108 @@
+#include <rr_common/planning/planner_metrics.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace rr {
+
+LatencyHistogram::LatencyHistogram() : count_(0), sum_ns_(0), max_ns_(0) {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+double LatencyHistogram::BucketUpperBound(int bucket) {
+    return kMinMs * std::exp2(static_cast<double>(bucket) / kBucketsPerOctave);
+}
+
+void LatencyHistogram::Add(double ms) {
+    int bucket = 0;
+    if (ms > kMinMs) {
+        bucket = static_cast<int>(std::ceil(std::log2(ms / kMinMs) * kBucketsPerOctave));
+        bucket = std::min(bucket, kNumBuckets - 1);
+    }
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    const auto ns = static_cast<uint64_t>(std::max(ms, 0.0) * 1e6);
+    sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max = max_ns_.load(std::memory_order_relaxed);
+    while (ns > max && !max_ns_.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+    count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::Count() const {
+    return count_.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::Mean() const {
+    const uint64_t count = Count();
+    return count == 0 ? 0 : sum_ns_.load(std::memory_order_relaxed) * 1e-6 / count;
+}
+
+double LatencyHistogram::Max() const {
+    return max_ns_.load(std::memory_order_relaxed) * 1e-6;
+}
+
+double LatencyHistogram::Percentile(double p) const {
+    // buckets may be a few samples ahead of or behind count_ while other threads record, so total them here
+    std::array<uint64_t, kNumBuckets> counts{};
+    uint64_t total = 0;
+    for (int i = 0; i < kNumBuckets; ++i) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p / 100.0 * total)));
+    uint64_t seen = 0;
+    for (int i = 0; i < kNumBuckets; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(BucketUpperBound(i), Max());
+        }
+    }
+    return Max();
+}
+
+const char* PlannerPhaseName(PlannerPhase phase) {
+    switch (phase) {
+        case PlannerPhase::MapIngest:
+            return "map_ingest";
+        case PlannerPhase::MapPreprocess:
+            return "map_preprocess";
+        case PlannerPhase::Optimize:
+            return "optimize";
+        case PlannerPhase::Rollout:
+            return "rollout";
+        case PlannerPhase::CostLookup:
+            return "cost_lookup";
+        case PlannerPhase::Publish:
+            return "publish";
+        case PlannerPhase::Total:
+            return "total";
+        default:
+            return "unknown";
+    }
+}
+
+PlannerMetrics::PlannerMetrics() : plans_(0), evaluations_(0), optimize_ns_(0) {}
+
+void PlannerMetrics::AddPlan(double optimize_ms, const CostFunctionTiming& timing) {
+    AddPhase(PlannerPhase::Optimize, optimize_ms);
+    AddPhase(PlannerPhase::Rollout, timing.rollout_ns * 1e-6);
+    AddPhase(PlannerPhase::CostLookup, timing.cost_lookup_ns * 1e-6);
+
+    plans_.fetch_add(1, std::memory_order_relaxed);
+    evaluations_.fetch_add(timing.evaluations, std::memory_order_relaxed);
+    optimize_ns_.fetch_add(static_cast<uint64_t>(optimize_ms * 1e6), std::memory_order_relaxed);
+}
+
+double PlannerMetrics::EvaluationsPerSecond() const {
+    const uint64_t ns = optimize_ns_.load(std::memory_order_relaxed);
+    return ns == 0 ? 0 : evaluations_.load(std::memory_order_relaxed) / (ns * 1e-9);
+}
+
+}  // namespace rr
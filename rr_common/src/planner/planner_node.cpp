@@ -1,264 +1,534 @@
 #include <geometry_msgs/PoseStamped.h>
 #include <nav_msgs/Path.h>
+#include <nodelet/nodelet.h>
 #include <parameter_assertions/assertions.h>
-#include <pcl/PCLPointCloud2.h>
-#include <pcl_conversions/pcl_conversions.h>
+#include <pluginlib/class_list_macros.h>
 #include <ros/ros.h>
 #include <rr_common/planning/annealing_optimizer.h>
 #include <rr_common/planning/bicycle_model.h>
-#include <rr_common/planning/distance_map.h>
+#include <rr_common/planning/coarse_to_fine.h>
+#include <rr_common/planning/control_spline.h>
+#include <rr_common/planning/cost_cache.h>
+#include <rr_common/planning/distance_map_ros.h>
 #include <rr_common/planning/effector_tracker.h>
+#include <rr_common/planning/flight_recorder.h>
 #include <rr_common/planning/hill_climb_optimizer.h>
-#include <rr_common/planning/inflation_map.h>
+#include <rr_common/planning/inflation_map_ros.h>
+#include <rr_common/planning/lattice_search_optimizer.h>
 #include <rr_common/planning/map_cost_interface.h>
-#include <rr_common/planning/nearest_point_cache.h>
+#include <rr_common/planning/motion_lattice.h>
+#include <rr_common/planning/nearest_point_cache_ros.h>
+#include <rr_common/planning/planner_metrics.h>
+#include <rr_common/planning/planning_ros.h>
+#include <rr_common/planning/trajectory_cost.h>
+#include <rr_common/planning/worker_pool.h>
+#include <rr_msgs/planner_metrics.h>
 #include <rr_msgs/speed.h>
 #include <rr_msgs/steering.h>
+#include <std_srvs/Trigger.h>
+
+#include <atomic>
+#include <thread>
 
 #include <rr_common/linear_tracking_filter.hpp>
 
 constexpr int ctrl_dim = 1;
 
-std::unique_ptr<rr::PlanningOptimizer<ctrl_dim>> g_planner;
-std::unique_ptr<rr::MapCostInterface> g_map_cost_interface;
-std::unique_ptr<rr::BicycleModel> g_vehicle_model;
-std::unique_ptr<rr::EffectorTracker> g_effector_tracker;
+// returns nullptr for an unknown planner type, leaving the caller to report it
+std::unique_ptr<rr::PlanningOptimizer<ctrl_dim>> makeOptimizer(const ros::NodeHandle& nhp,
+                                                                 const std::string& planner_type) {
+    if (planner_type == "annealing") {
+        rr::AnnealingOptimizer<ctrl_dim>::Params params;
+        rr::LoadParams<ctrl_dim>(ros::NodeHandle(nhp, "annealing_optimizer"), params);
+        return std::make_unique<rr::AnnealingOptimizer<ctrl_dim>>(params);
+    } else if (planner_type == "hill_climbing") {
+        rr::HillClimbOptimizer<ctrl_dim>::Params params;
+        rr::LoadParams<ctrl_dim>(ros::NodeHandle(nhp, "hill_climb_optimizer"), params);
+        return std::make_unique<rr::HillClimbOptimizer<ctrl_dim>>(params);
+    }
+    return nullptr;
+}
 
-std::shared_ptr<rr::LinearTrackingFilter> g_speed_model;
-std::shared_ptr<rr::LinearTrackingFilter> g_steer_model;
+namespace rr {
+
+class Planner : public nodelet::Nodelet {
+  private:
+    std::unique_ptr<rr::PlanningOptimizer<ctrl_dim>> planner_;
+    std::unique_ptr<rr::MapCostInterface> map_cost_interface_;
+    std::unique_ptr<rr::BicycleModel> vehicle_model_;
+    std::unique_ptr<rr::EffectorTracker> effector_tracker_;
+    std::unique_ptr<rr::ControlSpline<ctrl_dim>> control_spline_;  // optimize over spline knots when set
+    std::unique_ptr<rr::CoarseToFinePlanner> coarse_to_fine_;      // explore at low resolution first when set
+    std::unique_ptr<rr::CostCache<ctrl_dim>> cost_cache_;          // memoize repeated candidates when set
+    std::unique_ptr<rr::MotionLattice> motion_lattice_;            // precomputed primitives, when configured
+    bool lattice_scoring_ = false;                                 // roll out candidates from motion_lattice_
+    std::unique_ptr<rr::BicycleModel> reverse_model_;              // reversing maneuvers, when enabled
+    std::unique_ptr<rr::PlanningOptimizer<ctrl_dim>> reverse_planner_;
+    std::unique_ptr<rr::WorkerPool> maneuver_pool_;  // runs the reverse optimization alongside the forward one
+    double reverse_hysteresis_ = 0;  // fraction by which the other direction's plan must be cheaper to switch
+    bool reversing_ = false;         // direction of the commanded plan
+
+    std::shared_ptr<rr::LinearTrackingFilter> speed_model_;
+    std::shared_ptr<rr::LinearTrackingFilter> steer_model_;
+
+    rr::CostWeights cost_weights_;
+    rr::Controls<ctrl_dim> last_controls_;
+    rr::Controls<ctrl_dim> last_reverse_controls_;
+
+    ros::Publisher speed_pub_;
+    ros::Publisher steer_pub_;
+    ros::Publisher viz_pub_;
+    ros::Publisher metrics_pub_;
+
+    rr_msgs::speedPtr speed_message_;
+    rr_msgs::steeringPtr steer_message_;
+
+    double steering_gain_ = 1.0;
+
+    rr::PlannerMetrics metrics_;
+    ros::WallTimer metrics_timer_;
+    ros::Timer plan_timer_;
+
+    std::unique_ptr<rr::FlightRecorder> flight_recorder_;
+    std::string flight_recording_directory_;
+    double flight_recording_latency_ms_ = 0;  // dump automatically when a plan takes longer than this; 0 disables
+    ros::WallDuration flight_recording_interval_;  // between automatic dumps
+    ros::WallTime last_automatic_dump_;
+    std::atomic<bool> flight_recording_in_progress_{ false };
+    std::thread flight_recording_thread_;  // the latest dump, joined before the next one and on unload
+    ros::ServiceServer dump_service_;
+
+    void update_messages(double speed, double angle) {
+        auto now = ros::Time::now();
+
+        speed_message_->speed = speed;
+        speed_message_->header.stamp = now;
+
+        steer_message_->angle = angle;
+        steer_message_->header.stamp = now;
+    }
 
-double k_map_cost_, k_speed_, k_steering_, k_angle_, collision_penalty_;
-rr::Controls<ctrl_dim> g_last_controls;
+    /**
+     * Write the flight recorder to a new file in the background, so the planning loop isn't held up by disk IO
+     * @param reason Logged with the file name
+     * @return path of the recording, or empty if a dump is already in progress
+     */
+    std::string dumpFlightRecording(const std::string& reason) {
+        if (flight_recording_in_progress_.exchange(true)) {
+            return "";
+        }
 
-ros::Publisher speed_pub;
-ros::Publisher steer_pub;
-ros::Publisher viz_pub;
+        std::string path = flight_recording_directory_ + "/planner_flight_" +
+                           std::to_string(ros::WallTime::now().toNSec()) + ".bin";
 
-rr_msgs::speedPtr speed_message;
-rr_msgs::steeringPtr steer_message;
+        if (flight_recording_thread_.joinable()) {
+            flight_recording_thread_.join();  // finished, since no dump is in progress
+        }
+        flight_recording_thread_ = std::thread([this, path, reason]() {
+            try {
+                size_t n = flight_recorder_->Dump(path);
+                ROS_WARN_STREAM("[Planner] " << reason << ": wrote " << n << " planning cycles to " << path);
+            } catch (std::exception& ex) {
+                ROS_ERROR_STREAM("[Planner] " << ex.what());
+            }
+            flight_recording_in_progress_ = false;
+        });
 
-enum reverse_state_t { OK, CAUTION, REVERSE };
+        return path;
+    }
 
-ros::Duration caution_duration;
-ros::Duration reverse_duration;
-ros::Time caution_start_time;
-ros::Time reverse_start_time;
-reverse_state_t reverse_state;
+    bool dumpFlightRecordingService(std_srvs::Trigger::Request&, std_srvs::Trigger::Response& res) {
+        res.message = dumpFlightRecording("requested");
+        res.success = !res.message.empty();
+        return true;
+    }
 
-double steering_gain;
+    /**
+     * Copy the planning inputs into a flight recorder entry
+     */
+    void fillRecordInputs(rr::PlanRecord& record) {
+        record.map_stamp = map_cost_interface_->GetMapStamp();
+        record.filter_time = steer_model_->GetLastUpdateTime();
+        record.steer_value = steer_model_->GetValue();
+        record.steer_target = steer_model_->GetTarget();
+        record.speed_value = speed_model_->GetValue();
+        record.speed_target = speed_model_->GetTarget();
+
+        record.ctrl_dim = ctrl_dim;
+        record.n_segments = static_cast<int32_t>(last_controls_.cols());
+        for (int i = 0; i < last_controls_.size() && i < rr::PlanRecord::kMaxControls; ++i) {
+            record.init_controls[i] = last_controls_.data()[i];
+        }
+    }
 
-double total_planning_time;
-size_t total_plans;
+    void processMap() {
+        auto start = ros::WallTime::now();
 
-void update_messages(double speed, double angle) {
-    auto now = ros::Time::now();
+        rr::PlanRecord record{};
+        record.stamp = start.toSec();
+        fillRecordInputs(record);
 
-    speed_message->speed = speed;
-    speed_message->header.stamp = now;
+        auto max_speed = speed_model_->GetValMax();
 
-    steer_message->angle = angle;
-    steer_message->header.stamp = now;
-}
+        rr::CostFunctionTiming timing;
+        auto make_cost_fn = [&](const rr::BicycleModel& model) {
+            if (lattice_scoring_ && motion_lattice_ && &model == vehicle_model_.get()) {
+                return rr::MakeCostFunction(*motion_lattice_, *map_cost_interface_, cost_weights_, max_speed, &timing);
+            }
+            return rr::MakeCostFunction(model, *map_cost_interface_, cost_weights_, max_speed, &timing);
+        };
+        rr::CostFunction<ctrl_dim> cost_fn = make_cost_fn(*vehicle_model_);
 
-void processMap() {
-    auto max_speed = g_speed_model->GetValMax();
-
-    rr::CostFunction<ctrl_dim> cost_fn = [&](const rr::Controls<ctrl_dim>& controls) -> double {
-        rr::TrajectoryRollout rollout;
-        g_vehicle_model->RollOutPath(controls, rollout);
-        const auto& path = rollout.path;
-
-        std::vector<double> map_costs = g_map_cost_interface->DistanceCost(path);
-        double cost = 0;
-        double inflator = 1;
-        double gamma = 1.01;
-        for (size_t i = 0; i < rollout.path.size(); ++i) {
-            cost *= gamma;
-            inflator *= gamma;
-            if (map_costs[i] >= 0) {
-                cost += k_map_cost_ * map_costs[i];
-                cost += k_speed_ * std::pow(max_speed - path[i].speed, 2);
-                cost += k_steering_ * std::abs(path[i].steer);
-                cost += k_angle_ * std::abs(path[i].pose.theta);
+        // costs only hold for this map and vehicle state, so the cache starts empty every plan
+        if (cost_cache_) {
+            cost_cache_->Clear();
+        }
+        auto memoize = [this](const rr::CostFunction<ctrl_dim>& fn) {
+            return cost_cache_ ? cost_cache_->Wrap(fn) : fn;
+        };
+
+        rr::Matrix<ctrl_dim, 2> ctrl_limits;
+        ctrl_limits << steer_model_->GetValMin(), steer_model_->GetValMax();
+
+        rr::TrajectoryPlan plan;
+        rr::Controls<ctrl_dim> controls;
+        auto optimize_forward = [&]() {
+            if (control_spline_) {
+                rr::Controls<ctrl_dim> init_knots = control_spline_->Fit(last_controls_, ctrl_limits);
+                rr::Controls<ctrl_dim> knots =
+                      planner_->Optimize(memoize(control_spline_->Wrap(cost_fn)), init_knots, ctrl_limits);
+                controls = control_spline_->Evaluate(knots);
+            } else if (coarse_to_fine_) {
+                auto make_memoized_cost_fn = [&](const rr::BicycleModel& model) {
+                    return memoize(make_cost_fn(model));
+                };
+                controls = coarse_to_fine_->Optimize(*planner_, make_memoized_cost_fn, *vehicle_model_,
+                                                      last_controls_, ctrl_limits);
             } else {
-                cost += collision_penalty_ * (path.size() - i);
-                break;
+                controls = planner_->Optimize(memoize(cost_fn), last_controls_, ctrl_limits);
             }
+            plan.cost = cost_fn(controls);
+        };
+
+        // the reverse family is optimized on its own worker while the forward one runs here
+        rr::TrajectoryPlan reverse_plan;
+        rr::Controls<ctrl_dim> reverse_controls;
+        auto optimize_reverse = [&]() {
+            // untimed: the timing counters belong to the forward optimization running alongside
+            rr::CostFunction<ctrl_dim> reverse_cost_fn =
+                  rr::MakeCostFunction(*reverse_model_, *map_cost_interface_, cost_weights_, max_speed);
+            reverse_controls = reverse_planner_->Optimize(reverse_cost_fn, last_reverse_controls_, ctrl_limits);
+            reverse_plan.cost = reverse_cost_fn(reverse_controls);
+        };
+
+        if (reverse_planner_) {
+            maneuver_pool_->ParallelFor(2, [&](int i) { i == 0 ? optimize_forward() : optimize_reverse(); });
+        } else {
+            optimize_forward();
+        }
+        auto optimize_end = ros::WallTime::now();
+
+        auto rollout_plan = [this](const rr::BicycleModel& model, const rr::Controls<ctrl_dim>& plan_controls,
+                               rr::TrajectoryPlan& plan_out) {
+            model.RollOutPath(plan_controls, plan_out.rollout);
+            std::vector<rr::real_t> map_costs = map_cost_interface_->DistanceCost(plan_out.rollout.path);
+            plan_out.has_collision =
+                  std::any_of(map_costs.begin(), map_costs.end(), [](rr::real_t x) { return x < 0; });
+        };
+        rollout_plan(*vehicle_model_, controls, plan);
+        last_controls_ = controls;
+
+        if (reverse_planner_) {
+            rollout_plan(*reverse_model_, reverse_controls, reverse_plan);
+            last_reverse_controls_ = reverse_controls;
+            // keep the current direction unless the other is clearly cheaper, so close costs don't flip it every plan
+            const double switch_factor = 1 - reverse_hysteresis_;
+            reversing_ = reversing_ ? !(plan.cost < reverse_plan.cost * switch_factor)
+                                    : reverse_plan.cost < plan.cost * switch_factor;
+        }
+        const rr::TrajectoryPlan& chosen_plan = reversing_ ? reverse_plan : plan;
+        auto rollout_end = ros::WallTime::now();
+
+        ROS_INFO_STREAM("Best path cost is " << chosen_plan.cost << ", collision = " << chosen_plan.has_collision
+                                             << (reversing_ ? ", reversing" : ""));
+
+        auto now = ros::Time::now();
+        if (chosen_plan.has_collision) {
+            // the previous command is usually what led here, so hold still until a maneuver clears
+            ROS_WARN_STREAM("Planner: no collision-free maneuver found; stopping");
+            speed_model_->Update(0, now.toSec());
+            update_messages(0, steer_message_->angle);
+        } else {
+            speed_model_->Update(chosen_plan.rollout.apply_speed, now.toSec());
+            update_messages(speed_model_->GetValue(), chosen_plan.rollout.apply_steering * steering_gain_);
         }
-        return cost / inflator;
-    };
-
-    rr::Matrix<ctrl_dim, 2> ctrl_limits;
-    ctrl_limits << g_steer_model->GetValMin(), g_steer_model->GetValMax();
-
-    rr::TrajectoryPlan plan;
-    rr::Controls<ctrl_dim> controls = g_planner->Optimize(cost_fn, g_last_controls, ctrl_limits);
-    plan.cost = cost_fn(controls);
 
-    g_vehicle_model->RollOutPath(controls, plan.rollout);
-    std::vector<double> map_costs = g_map_cost_interface->DistanceCost(plan.rollout.path);
-    auto negative_it = std::find_if(map_costs.begin(), map_costs.end(), [](double x) { return x < 0; });
-    plan.has_collision = (negative_it != map_costs.end());
+        speed_pub_.publish(speed_message_);
+        steer_pub_.publish(steer_message_);
 
-    g_last_controls = controls;
+        if (viz_pub_.getNumSubscribers() > 0) {
+            nav_msgs::Path pathMsg;
 
-    ROS_INFO_STREAM("Best path cost is " << plan.cost << ", collision = " << plan.has_collision);
+            for (size_t i = 0; i < chosen_plan.rollout.path.size(); ++i) {
+                geometry_msgs::PoseStamped ps;
+                ps.pose.position.x = chosen_plan.rollout.path.x[i];
+                ps.pose.position.y = chosen_plan.rollout.path.y[i];
+                pathMsg.poses.push_back(ps);
+            }
 
-    // update impasse state machine
-    auto now = ros::Time::now();
+            pathMsg.header.frame_id = "base_footprint";
+            viz_pub_.publish(pathMsg);
+        }
+        auto end = ros::WallTime::now();
 
-    if (OK == reverse_state) {
-        if (plan.has_collision) {
-            if (caution_duration.toSec() <= 0) {
-                reverse_state = REVERSE;
-                reverse_start_time = now;
-            } else {
-                reverse_state = CAUTION;
-                caution_start_time = now;
-            }
+        for (int i = 0; i < controls.size() && i < rr::PlanRecord::kMaxControls; ++i) {
+            record.controls[i] = controls.data()[i];
         }
-    } else if (CAUTION == reverse_state) {
-        if (!plan.has_collision) {
-            reverse_state = OK;
-        } else if (now - caution_start_time > caution_duration) {
-            reverse_state = REVERSE;
-            reverse_start_time = now;
+        record.cost = plan.cost;
+        record.has_collision = plan.has_collision;
+        record.cost_evaluations = timing.evaluations;
+        if (reverse_planner_) {
+            record.reversing = reversing_;
+            record.reverse_cost = reverse_plan.cost;
+            record.reverse_has_collision = reverse_plan.has_collision;
         }
-    } else if (REVERSE == reverse_state) {
-        if (now - reverse_start_time > reverse_duration) {
-            reverse_state = CAUTION;
-            caution_start_time = now;
+        record.optimize_ms = (optimize_end - start).toSec() * 1000;
+        record.rollout_ms = (rollout_end - optimize_end).toSec() * 1000;
+        record.publish_ms = (end - rollout_end).toSec() * 1000;
+        record.total_ms = (end - start).toSec() * 1000;
+        flight_recorder_->Record(record);
+
+        metrics_.AddPlan(record.optimize_ms, timing);
+        metrics_.AddPhase(rr::PlannerPhase::Publish, record.publish_ms);
+        metrics_.AddPhase(rr::PlannerPhase::Total, record.total_ms);
+        ROS_DEBUG("Planning took %0.1fms, %u cost evaluations", record.total_ms, record.cost_evaluations);
+        if (cost_cache_) {
+            ROS_DEBUG("Cost cache: %lu hits, %lu misses", cost_cache_->GetHits(), cost_cache_->GetMisses());
         }
-    } else {
-        ROS_ERROR_STREAM("Planner encountered unknown reverse state");
-    }
 
-    if (REVERSE == reverse_state) {
-        update_messages(-0.8, 0);
-        ROS_WARN_STREAM("Planner reversing");
-    } else if (plan.has_collision) {
-        ROS_WARN_STREAM("Planner: no path found but not reversing; reusing previous message");
-    } else {
-        g_speed_model->Update(plan.rollout.apply_speed, now.toSec());
-        update_messages(g_speed_model->GetValue(), plan.rollout.apply_steering * steering_gain);
+        // a burst of slow plans is one incident, and one dump holds all of it
+        if (flight_recording_latency_ms_ > 0 && record.total_ms > flight_recording_latency_ms_ &&
+            end - last_automatic_dump_ >= flight_recording_interval_) {
+            if (!dumpFlightRecording("planning took " + std::to_string(record.total_ms) + " ms").empty()) {
+                last_automatic_dump_ = end;
+            }
+        }
     }
 
-    speed_pub.publish(speed_message);
-    steer_pub.publish(steer_message);
-
-    if (viz_pub.getNumSubscribers() > 0) {
-        nav_msgs::Path pathMsg;
-
-        for (auto path_point : plan.rollout.path) {
-            geometry_msgs::PoseStamped ps;
-            ps.pose.position.x = path_point.pose.x;
-            ps.pose.position.y = path_point.pose.y;
-            pathMsg.poses.push_back(ps);
+    void publishMetrics(const ros::WallTimerEvent&) {
+        rr_msgs::planner_metricsPtr msg(new rr_msgs::planner_metrics);
+        msg->header.stamp = ros::Time::now();
+        msg->plans = metrics_.Plans();
+        msg->cost_evaluations = metrics_.CostEvaluations();
+        msg->evaluations_per_second = metrics_.EvaluationsPerSecond();
+
+        for (int i = 0; i < static_cast<int>(rr::PlannerPhase::Count); ++i) {
+            auto phase = static_cast<rr::PlannerPhase>(i);
+            const rr::LatencyHistogram& histogram = metrics_.Phase(phase);
+
+            rr_msgs::planner_phase_metrics phase_msg;
+            phase_msg.phase = rr::PlannerPhaseName(phase);
+            phase_msg.count = histogram.Count();
+            phase_msg.mean_ms = histogram.Mean();
+            phase_msg.p50_ms = histogram.Percentile(50);
+            phase_msg.p90_ms = histogram.Percentile(90);
+            phase_msg.p99_ms = histogram.Percentile(99);
+            phase_msg.max_ms = histogram.Max();
+            msg->phases.push_back(phase_msg);
         }
 
-        pathMsg.header.frame_id = "base_footprint";
-        viz_pub.publish(pathMsg);
+        metrics_pub_.publish(msg);
     }
-}
 
-int main(int argc, char** argv) {
-    ros::init(argc, argv, "planner");
-
-    ros::NodeHandle nh;
-    ros::NodeHandle nhp("~");
-
-    assertions::getParam(nhp, "k_map_cost", k_map_cost_);
-    assertions::getParam(nhp, "k_speed", k_speed_);
-    assertions::getParam(nhp, "k_steering", k_steering_);
-    assertions::getParam(nhp, "k_angle", k_angle_);
-    assertions::getParam(nhp, "collision_penalty", collision_penalty_);
-
-    std::string map_type;
-    assertions::getParam(nhp, "map_type", map_type);
-    if (map_type == "obstacle_points") {
-        g_map_cost_interface = std::make_unique<rr::NearestPointCache>(ros::NodeHandle(nhp, "obstacle_points_map"));
-    } else if (map_type == "inflation_map") {
-        g_map_cost_interface = std::make_unique<rr::InflationMap>(ros::NodeHandle(nhp, "inflation_map"));
-    } else if (map_type == "distance_map") {
-        g_map_cost_interface = std::make_unique<rr::DistanceMap>(ros::NodeHandle(nhp, "distance_map"));
-    } else {
-        ROS_ERROR_STREAM("[Planner] Error: unknown map type \"" << map_type << "\"");
-        ros::shutdown();
+    /**
+     * Track the effectors, and plan whenever a new map has arrived
+     */
+    void update(const ros::TimerEvent&) {
+        steer_model_->Update(effector_tracker_->getAngle(), ros::Time::now().toSec());
+        speed_model_->Update(effector_tracker_->getSpeed(), ros::Time::now().toSec());
+
+        if (map_cost_interface_->IsMapUpdated()) {
+            map_cost_interface_->StopUpdates();
+            metrics_.AddPhase(rr::PlannerPhase::MapIngest, map_cost_interface_->GetMapIngestTime());
+            metrics_.AddPhase(rr::PlannerPhase::MapPreprocess, map_cost_interface_->GetMapPreprocessTime());
+            processMap();
+            map_cost_interface_->SetMapStale();
+            map_cost_interface_->StartUpdates();
+        }
     }
 
-    g_steer_model = std::make_shared<rr::LinearTrackingFilter>(ros::NodeHandle(nhp, "steering_filter"));
-    g_speed_model = std::make_shared<rr::LinearTrackingFilter>(ros::NodeHandle(nhp, "speed_filter"));
-    g_vehicle_model =
-          std::make_unique<rr::BicycleModel>(ros::NodeHandle(nhp, "bicycle_model"), g_steer_model, g_speed_model);
+    void onInit() override {
+        auto nh = getNodeHandle();
+        auto nhp = getPrivateNodeHandle();
+
+        rr::LoadParams(nhp, cost_weights_);
+
+        std::string map_type;
+        assertions::getParam(nhp, "map_type", map_type);
+        if (map_type == "obstacle_points") {
+            map_cost_interface_ =
+                  std::make_unique<rr::NearestPointCacheRos>(ros::NodeHandle(nhp, "obstacle_points_map"));
+        } else if (map_type == "inflation_map") {
+            map_cost_interface_ = std::make_unique<rr::InflationMapRos>(ros::NodeHandle(nhp, "inflation_map"));
+        } else if (map_type == "distance_map") {
+            map_cost_interface_ = std::make_unique<rr::DistanceMapRos>(ros::NodeHandle(nhp, "distance_map"));
+        } else {
+            NODELET_ERROR_STREAM("Error: unknown map type \"" << map_type << "\"");
+            return;
+        }
 
-    std::string planner_type;
-    assertions::getParam(nhp, "planner_type", planner_type);
+        using FilterParams = rr::LinearTrackingFilter::Params;
+        steer_model_ = std::make_shared<rr::LinearTrackingFilter>(
+              rr::LoadParams<FilterParams>(ros::NodeHandle(nhp, "steering_filter")));
+        speed_model_ = std::make_shared<rr::LinearTrackingFilter>(
+              rr::LoadParams<FilterParams>(ros::NodeHandle(nhp, "speed_filter")));
+        auto bicycle_params = rr::LoadParams<rr::BicycleModel::Params>(ros::NodeHandle(nhp, "bicycle_model"));
+        vehicle_model_ = std::make_unique<rr::BicycleModel>(bicycle_params, steer_model_, speed_model_);
+
+        ros::NodeHandle nh_motion_lattice(nhp, "motion_lattice");
+        auto motion_lattice_file = assertions::param(nh_motion_lattice, "file", std::string());
+        lattice_scoring_ = assertions::param(nh_motion_lattice, "score_candidates", true);
+        if (!motion_lattice_file.empty()) {
+            try {
+                motion_lattice_ = std::make_unique<rr::MotionLattice>(motion_lattice_file, bicycle_params, steer_model_,
+                                                                       speed_model_);
+                ROS_INFO_STREAM("[Planner] Loaded " << motion_lattice_->GetNumPrimitives() << " motion primitives from "
+                                                    << motion_lattice_file);
+            } catch (const std::runtime_error& e) {
+                NODELET_ERROR_STREAM("Error: " << e.what());
+                return;
+            }
+        }
 
-    if (planner_type == "annealing") {
-        g_planner = std::make_unique<rr::AnnealingOptimizer<ctrl_dim>>(ros::NodeHandle(nhp, "annealing_optimizer"));
-    } else if (planner_type == "hill_climbing") {
-        g_planner = std::make_unique<rr::HillClimbOptimizer<ctrl_dim>>(ros::NodeHandle(nhp, "hill_climb_optimizer"));
-    } else {
-        ROS_ERROR_STREAM("[Planner] Error: unknown planner type \"" << planner_type << "\"");
-        ros::shutdown();
-    }
+        std::string planner_type;
+        assertions::getParam(nhp, "planner_type", planner_type);
+
+        if (planner_type == "lattice_search") {
+            if (!motion_lattice_) {
+                NODELET_ERROR("Error: planner type \"lattice_search\" needs motion_lattice/file");
+                return;
+            } else if (nhp.param("n_knots", 0) > 0 || nhp.hasParam("multiresolution/levels")) {
+                // the search builds whole per-segment plans itself, so knots or coarse levels would be dropped
+                NODELET_ERROR("Error: planner type \"lattice_search\" supports neither n_knots nor multiresolution");
+                return;
+            } else {
+                ros::NodeHandle nh_lattice_search(nhp, "lattice_search");
+                auto local_planner_type = assertions::param(nh_lattice_search, "local_planner_type", std::string());
+                std::unique_ptr<rr::PlanningOptimizer<ctrl_dim>> local_planner;
+                if (!local_planner_type.empty()) {
+                    local_planner = makeOptimizer(nhp, local_planner_type);
+                    if (!local_planner) {
+                        NODELET_ERROR_STREAM("Error: unknown lattice_search/local_planner_type \""
+                                             << local_planner_type << "\"");
+                        return;
+                    }
+                }
+                planner_ = std::make_unique<rr::LatticeSearchOptimizer>(
+                      rr::LoadParams<rr::LatticeSearchOptimizer::Params>(nh_lattice_search), *motion_lattice_,
+                      *map_cost_interface_, cost_weights_, steer_model_, speed_model_, std::move(local_planner));
+            }
+        } else {
+            planner_ = makeOptimizer(nhp, planner_type);
+            if (!planner_) {
+                NODELET_ERROR_STREAM("Error: unknown planner type \"" << planner_type << "\"");
+                return;
+            }
+        }
 
-    int n_control_points = 0;
-    assertions::getParam(nhp, "n_segments", n_control_points);
-    g_last_controls = rr::Controls<ctrl_dim>(ctrl_dim, n_control_points);
-    g_last_controls.setZero();
+        int n_control_points = 0;
+        assertions::getParam(nhp, "n_segments", n_control_points);
+        last_controls_ = rr::Controls<ctrl_dim>(ctrl_dim, n_control_points);
 
-    caution_duration = ros::Duration(assertions::param(nhp, "impasse_caution_duration", 0.0));
-    reverse_duration = ros::Duration(assertions::param(nhp, "impasse_reverse_duration", 0.0));
-    caution_start_time = ros::Time(0);
-    reverse_start_time = ros::Time(0);
-    reverse_state = OK;
+        int n_knots = assertions::param(nhp, "n_knots", 0);
+        if (n_knots > 0) {
+            control_spline_ = std::make_unique<rr::ControlSpline<ctrl_dim>>(n_knots, n_control_points);
+        }
 
-    steering_gain = assertions::param(nhp, "steering_gain", 1.0);
+        ros::NodeHandle nh_cost_cache(nhp, "cost_cache");
+        double cost_cache_resolution = assertions::param(nh_cost_cache, "resolution", 0.0);
+        if (cost_cache_resolution > 0) {
+            int capacity = assertions::param(nh_cost_cache, "capacity", 8192);
+            cost_cache_ = std::make_unique<rr::CostCache<ctrl_dim>>(capacity, cost_cache_resolution);
+        }
 
-    speed_pub = nh.advertise<rr_msgs::speed>("plan/speed", 1);
-    steer_pub = nh.advertise<rr_msgs::steering>("plan/steering", 1);
-    viz_pub = nh.advertise<nav_msgs::Path>("plan/path", 1);
+        ros::NodeHandle nh_multiresolution(nhp, "multiresolution");
+        if (nh_multiresolution.hasParam("levels")) {
+            if (control_spline_) {
+                ROS_WARN("[Planner] multiresolution is ignored when n_knots is set");
+            }
+            coarse_to_fine_ = std::make_unique<rr::CoarseToFinePlanner>(
+                  rr::LoadParams<rr::CoarseToFinePlanner::Params>(nh_multiresolution), bicycle_params, n_control_points,
+                  steer_model_, speed_model_);
+        }
+        last_controls_.setZero();
+
+        // the reverse optimizer has its own parameters, since it runs alongside the forward one
+        ros::NodeHandle nh_reverse(nhp, "reverse");
+        auto reverse_planner_type = assertions::param(nh_reverse, "planner_type", std::string());
+        if (!reverse_planner_type.empty()) {
+            if (speed_model_->GetValMin() >= 0) {
+                ROS_WARN(
+                      "[Planner] reverse/planner_type is ignored since speed_filter/val_min doesn't allow reversing");
+            } else {
+                rr::BicycleModel::Params reverse_params = bicycle_params;
+                reverse_params.reverse = true;
+                reverse_model_ = std::make_unique<rr::BicycleModel>(reverse_params, steer_model_, speed_model_);
+                reverse_planner_ = makeOptimizer(nh_reverse, reverse_planner_type);
+                if (!reverse_planner_) {
+                    NODELET_ERROR_STREAM("Error: unknown reverse/planner_type \"" << reverse_planner_type << "\"");
+                    return;
+                }
+                int reverse_n_segments = assertions::param(nh_reverse, "n_segments", 3);
+                last_reverse_controls_ = rr::Controls<ctrl_dim>::Zero(ctrl_dim, reverse_n_segments);
+                assertions::param(nh_reverse, "hysteresis", reverse_hysteresis_, 0.2,
+                                  { assertions::greater_eq(0.0), assertions::less(1.0) });
+                maneuver_pool_ = std::make_unique<rr::WorkerPool>(1);
+            }
+        }
 
-    speed_message.reset(new rr_msgs::speed);
-    steer_message.reset(new rr_msgs::steering);
-    update_messages(0, 0);
-    g_effector_tracker =
-          std::make_unique<rr::EffectorTracker>(ros::NodeHandle(nhp, "effector_tracker"), speed_message, steer_message);
+        steering_gain_ = assertions::param(nhp, "steering_gain", 1.0);
 
-    total_planning_time = 0;
-    total_plans = 0;
+        speed_pub_ = nh.advertise<rr_msgs::speed>("plan/speed", 1);
+        steer_pub_ = nh.advertise<rr_msgs::steering>("plan/steering", 1);
+        viz_pub_ = nh.advertise<nav_msgs::Path>("plan/path", 1);
+        metrics_pub_ = nh.advertise<rr_msgs::planner_metrics>("plan/metrics", 1);
 
-    g_steer_model->Reset(0, ros::Time::now().toSec());
-    g_speed_model->Reset(0, ros::Time::now().toSec());
+        speed_message_.reset(new rr_msgs::speed);
+        steer_message_.reset(new rr_msgs::steering);
+        update_messages(0, 0);
+        effector_tracker_ = std::make_unique<rr::EffectorTracker>(ros::NodeHandle(nhp, "effector_tracker"),
+                                                                  speed_message_, steer_message_);
 
-    g_map_cost_interface->SetMapStale();
+        double metrics_period = assertions::param(nhp, "metrics_period", 1.0);
+        metrics_timer_ = nh.createWallTimer(ros::WallDuration(metrics_period), &Planner::publishMetrics, this);
 
-    ROS_INFO("planner initialized");
+        ros::NodeHandle nh_recorder(nhp, "flight_recorder");
+        int flight_recorder_capacity = assertions::param(nh_recorder, "capacity", 300);
+        flight_recorder_ = std::make_unique<rr::FlightRecorder>(flight_recorder_capacity);
+        flight_recording_directory_ = assertions::param(nh_recorder, "directory", std::string("."));
+        flight_recording_latency_ms_ = assertions::param(nh_recorder, "dump_latency_ms", 0.0);
+        flight_recording_interval_ = ros::WallDuration(assertions::param(nh_recorder, "dump_interval", 30.0));
+        dump_service_ = nhp.advertiseService("dump_flight_recording", &Planner::dumpFlightRecordingService, this);
 
-    ros::Rate rate(30);
-    while (ros::ok()) {
-        rate.sleep();
-        ros::spinOnce();
+        steer_model_->Reset(0, ros::Time::now().toSec());
+        speed_model_->Reset(0, ros::Time::now().toSec());
 
-        g_steer_model->Update(g_effector_tracker->getAngle(), ros::Time::now().toSec());
-        g_speed_model->Update(g_effector_tracker->getSpeed(), ros::Time::now().toSec());
+        map_cost_interface_->SetMapStale();
 
-        if (g_map_cost_interface->IsMapUpdated()) {
-            auto start = ros::WallTime::now();
+        ROS_INFO("planner initialized");
 
-            g_map_cost_interface->StopUpdates();
-            processMap();
-            g_map_cost_interface->SetMapStale();
-            g_map_cost_interface->StartUpdates();
-
-            double seconds = (ros::WallTime::now() - start).toSec();
-            total_planning_time += seconds;
-            total_plans++;
-            double sec_avg = total_planning_time / total_plans;
-            ROS_INFO("PlanningOptimizer took %0.1fms, average %0.2fms", seconds * 1000, sec_avg * 1000);
+        // the map is only read between map callbacks, since both run on this nodelet's single-threaded queue
+        plan_timer_ = nh.createTimer(ros::Duration(1.0 / 30), &Planner::update, this);
+    }
+
+  public:
+    ~Planner() override {
+        if (flight_recording_thread_.joinable()) {
+            flight_recording_thread_.join();
         }
     }
+};
 
-    return 0;
-}
+}  // namespace rr
+
+PLUGINLIB_EXPORT_CLASS(rr::Planner, nodelet::Nodelet);
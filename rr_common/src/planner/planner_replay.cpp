@@ -0,0 +1,473 @@
+/**
+ * Offline planner replay: feeds the maps and vehicle state recorded in a bag through the same map cost and optimizer
+ * pipeline as planner_node, as fast as possible and without a ROS master, then reports plan latency, cost, and
+ * collision statistics for each planner configuration.
+ *
+ * Usage: planner_replay [--flight-recording <recording.bin>] <bag> <planner_config.yaml> [<planner_config.yaml> ...]
+ *
+ * Each config is a planner parameter file such as rr_evgp/conf/planner_sim.yaml. The map topic follows map_type,
+ * and vehicle state comes from the effector_tracker topics. Obstacle point maps may be recorded in either form, the
+ * PointCloud2 or its compact subtopic; the compact one is used if the bag has both. Maps in a different frame than
+ * the robot are placed using /tf and /tf_static from the bag.
+ *
+ * With a flight recording dumped by planner_node, only the recorded cycles are replanned, each starting from the
+ * recorded filter state and warm start, and the recorded and replayed latency and cost are printed side by side.
+ */
+
+#include <nav_msgs/OccupancyGrid.h>
+#include <nav_msgs/Odometry.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <rr_common/planning/annealing_optimizer.h>
+#include <rr_common/planning/bicycle_model.h>
+#include <rr_common/planning/coarse_to_fine.h>
+#include <rr_common/planning/cost_cache.h>
+#include <rr_common/planning/control_spline.h>
+#include <rr_common/planning/distance_map.h>
+#include <rr_common/planning/flight_recorder.h>
+#include <rr_common/planning/hill_climb_optimizer.h>
+#include <rr_common/planning/inflation_map.h>
+#include <rr_common/planning/lattice_search_optimizer.h>
+#include <rr_common/planning/motion_lattice.h>
+#include <rr_common/planning/nearest_point_cache.h>
+#include <rr_common/planning/planning_ros.h>
+#include <rr_common/planning/trajectory_cost.h>
+#include <rr_common/planning/yaml_params.h>
+#include <rr_msgs/chassis_state.h>
+#include <rr_msgs/obstacle_points.h>
+#include <rr_msgs/speed.h>
+#include <rr_msgs/steering.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <tf2/buffer_core.h>
+#include <tf2/exceptions.h>
+#include <tf2_msgs/TFMessage.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+#include <rr_common/linear_tracking_filter.hpp>
+#include <rr_common/obstacle_transport.hpp>
+
+constexpr int ctrl_dim = 1;
+
+struct ReplayConfig {
+    std::string name;
+    YAML::Node yaml;
+    std::string map_type;
+    std::string map_topic;
+    std::string robot_base_frame;
+    std::string speed_topic, speed_type;
+    std::string steering_topic, steering_type;
+    int n_segments;
+    int n_knots;
+};
+
+struct PlanStats {
+    std::vector<double> latency_ms;
+    std::vector<double> cost;
+    size_t collisions = 0;
+    size_t evaluations = 0;
+    size_t skipped_maps = 0;
+};
+
+std::unique_ptr<rr::PlanningOptimizer<ctrl_dim>> MakeOptimizer(const YAML::Node& yaml,
+                                                                const std::string& planner_type) {
+    if (planner_type == "annealing") {
+        const auto node = yaml["annealing_optimizer"];
+        rr::AnnealingOptimizer<ctrl_dim>::Params params;
+        params.annealing_steps = rr::YamlParam<int>(node, "annealing_steps");
+        params.acceptance_scale = rr::YamlParam<double>(node, "acceptance_scale");
+        params.temperature_end = rr::YamlParam<double>(node, "temperature_end");
+        params.num_chains = node["num_chains"].as<int>(params.num_chains);
+        params.swap_interval = node["swap_interval"].as<int>(params.swap_interval);
+        params.batch_size = node["batch_size"].as<int>(params.batch_size);
+        params.batch_sample = node["batch_sample"].as<bool>(params.batch_sample);
+        params.stddev_start << rr::YamlParam<std::vector<double>>(node, "stddevs_start").at(0);
+        return std::make_unique<rr::AnnealingOptimizer<ctrl_dim>>(params);
+    } else if (planner_type == "hill_climbing") {
+        const auto node = yaml["hill_climb_optimizer"];
+        rr::HillClimbOptimizer<ctrl_dim>::Params params;
+        params.num_workers = rr::YamlParam<int>(node, "num_workers");
+        params.num_restarts = rr::YamlParam<int>(node, "num_restarts");
+        params.local_optimum_tries = rr::YamlParam<int>(node, "local_optimum_tries");
+        params.neighbor_stddev << rr::YamlParam<std::vector<double>>(node, "neighbor_stddev").at(0);
+        return std::make_unique<rr::HillClimbOptimizer<ctrl_dim>>(params);
+    }
+    throw std::runtime_error("unknown planner type \"" + planner_type + "\"");
+}
+
+std::unique_ptr<rr::MapCostInterface> MakeMapCost(const ReplayConfig& config) {
+    if (config.map_type == "obstacle_points") {
+        const auto node = config.yaml["obstacle_points_map"];
+        rr::NearestPointCache::Params params{ rr::LoadRectangle(node["map_limits"]), rr::LoadRectangle(node["hitbox"]),
+                                              rr::YamlParam<double>(node, "cache_resolution"),
+                                              rr::YamlParam<double>(node, "distance_decay_factor") };
+        return std::make_unique<rr::NearestPointCache>(params);
+    } else if (config.map_type == "inflation_map") {
+        const auto node = config.yaml["inflation_map"];
+        rr::InflationMap::Params params{ rr::LoadRectangle(node["hitbox"]),
+                                         rr::YamlParam<int>(node, "lethal_threshold") };
+        return std::make_unique<rr::InflationMap>(params);
+    } else if (config.map_type == "distance_map") {
+        const auto node = config.yaml["distance_map"];
+        rr::DistanceMap::Params params{ rr::LoadRectangle(node["hitbox"]),
+                                        rr::YamlParam<double>(node, "cost_scaling_factor"),
+                                        rr::YamlParam<double>(node, "wall_inflation") };
+        return std::make_unique<rr::DistanceMap>(params);
+    }
+    throw std::runtime_error("unknown map type \"" + config.map_type + "\"");
+}
+
+ReplayConfig LoadConfig(const std::string& path) {
+    ReplayConfig config;
+    config.name = path;
+    config.yaml = YAML::LoadFile(path);
+    config.map_type = rr::YamlParam<std::string>(config.yaml, "map_type");
+    config.n_segments = rr::YamlParam<int>(config.yaml, "n_segments");
+    config.n_knots = config.yaml["n_knots"].as<int>(0);
+
+    if (config.map_type == "obstacle_points") {
+        config.map_topic = rr::YamlParam<std::string>(config.yaml["obstacle_points_map"], "input_cloud_topic");
+        config.robot_base_frame = "base_footprint";
+    } else if (config.map_type == "distance_map") {
+        config.map_topic = rr::YamlParam<std::string>(config.yaml["distance_map"], "map_topic");
+        config.robot_base_frame = rr::YamlParam<std::string>(config.yaml["distance_map"], "robot_base_frame");
+    } else {
+        config.map_topic = rr::YamlParam<std::string>(config.yaml[config.map_type], "map_topic");
+        config.robot_base_frame = "base_footprint";
+    }
+
+    const auto tracker = config.yaml["effector_tracker"];
+    config.speed_topic = rr::YamlParam<std::string>(tracker["speed"], "message_topic");
+    config.speed_type = rr::YamlParam<std::string>(tracker["speed"], "message_type");
+    config.steering_topic = rr::YamlParam<std::string>(tracker["steering"], "message_topic");
+    config.steering_type = rr::YamlParam<std::string>(tracker["steering"], "message_type");
+    return config;
+}
+
+/**
+ * Nearest-rank percentile of an unsorted sample
+ */
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    auto rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+    return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+}
+
+/**
+ * Find the recorded cycle that planned on the map with this stamp
+ */
+const rr::PlanRecord* FindRecord(const std::vector<rr::PlanRecord>& recording, double map_stamp) {
+    auto it = std::find_if(recording.begin(), recording.end(),
+                           [map_stamp](const rr::PlanRecord& r) { return std::abs(r.map_stamp - map_stamp) < 1e-6; });
+    return it == recording.end() ? nullptr : &*it;
+}
+
+PlanStats Replay(const std::string& bag_path, const ReplayConfig& config,
+                 const std::vector<rr::PlanRecord>& recording) {
+    const auto& yaml = config.yaml;
+    auto steer_model = std::make_shared<rr::LinearTrackingFilter>(rr::LoadFilter(yaml["steering_filter"]));
+    auto speed_model = std::make_shared<rr::LinearTrackingFilter>(rr::LoadFilter(yaml["speed_filter"]));
+    const auto bicycle_node = yaml["bicycle_model"];
+    rr::BicycleModel::Params bicycle_params = rr::LoadBicycleModel(bicycle_node);
+    bicycle_params.lookup_table_size = bicycle_node["lookup_table_size"].as<int>(0);
+    rr::BicycleModel vehicle_model(bicycle_params, steer_model, speed_model);
+
+    std::unique_ptr<rr::MotionLattice> motion_lattice;
+    if (const auto file = yaml["motion_lattice"]["file"].as<std::string>(""); !file.empty()) {
+        motion_lattice = std::make_unique<rr::MotionLattice>(file, bicycle_params, steer_model, speed_model);
+    }
+    const bool lattice_scoring = motion_lattice && yaml["motion_lattice"]["score_candidates"].as<bool>(true);
+
+    auto map_cost = MakeMapCost(config);
+    const rr::CostWeights weights{ rr::YamlParam<double>(yaml, "k_map_cost"), rr::YamlParam<double>(yaml, "k_speed"),
+                                   rr::YamlParam<double>(yaml, "k_steering"), rr::YamlParam<double>(yaml, "k_angle"),
+                                   rr::YamlParam<double>(yaml, "collision_penalty") };
+
+    std::unique_ptr<rr::PlanningOptimizer<ctrl_dim>> optimizer;
+    if (const auto planner_type = rr::YamlParam<std::string>(yaml, "planner_type"); planner_type == "lattice_search") {
+        if (!motion_lattice) {
+            throw std::runtime_error("planner type \"lattice_search\" needs motion_lattice/file");
+        }
+        if (config.n_knots > 0 || yaml["multiresolution"]) {
+            throw std::runtime_error("planner type \"lattice_search\" supports neither n_knots nor multiresolution");
+        }
+        const auto node = yaml["lattice_search"];
+        rr::LatticeSearchOptimizer::Params params;
+        params.deadline_ms = rr::YamlParam<double>(node, "deadline_ms");
+        params.xy_resolution = rr::YamlParam<double>(node, "xy_resolution");
+        params.theta_bins = rr::YamlParam<int>(node, "theta_bins");
+        params.num_controls = rr::YamlParam<int>(node, "num_controls");
+        params.epsilon_start = node["epsilon_start"].as<double>(3.0);
+        params.epsilon_step = node["epsilon_step"].as<double>(1.0);
+        params.max_expansions = node["max_expansions"].as<int>(100000);
+        params.reuse_stride = node["reuse_stride"].as<int>(0);
+        params.reuse_tolerance = node["reuse_tolerance"].as<double>(0.05);
+        const auto local_planner_type = node["local_planner_type"].as<std::string>("");
+        optimizer = std::make_unique<rr::LatticeSearchOptimizer>(
+              params, *motion_lattice, *map_cost, weights, steer_model, speed_model,
+              local_planner_type.empty() ? nullptr : MakeOptimizer(yaml, local_planner_type));
+    } else {
+        optimizer = MakeOptimizer(yaml, planner_type);
+    }
+
+    rr::Matrix<ctrl_dim, 2> ctrl_limits;
+    ctrl_limits << steer_model->GetValMin(), steer_model->GetValMax();
+    rr::Controls<ctrl_dim> last_controls(ctrl_dim, config.n_segments);
+    last_controls.setZero();
+
+    std::unique_ptr<rr::ControlSpline<ctrl_dim>> control_spline;
+    if (config.n_knots > 0) {
+        control_spline = std::make_unique<rr::ControlSpline<ctrl_dim>>(config.n_knots, config.n_segments);
+    }
+
+    std::unique_ptr<rr::CoarseToFinePlanner> coarse_to_fine;
+    if (const auto node = yaml["multiresolution"]) {
+        rr::CoarseToFinePlanner::Params params;
+        params.levels = rr::YamlParam<std::vector<int>>(node, "levels");
+        params.dt_factor = node["dt_factor"].as<int>(2);
+        params.refine_stddev << rr::YamlParam<std::vector<double>>(node, "refine_stddev").at(0);
+        params.refine_tries = rr::YamlParam<int>(node, "refine_tries");
+        coarse_to_fine = std::make_unique<rr::CoarseToFinePlanner>(params, bicycle_params, config.n_segments,
+                                                                   steer_model, speed_model);
+    }
+
+    std::unique_ptr<rr::CostCache<ctrl_dim>> cost_cache;
+    if (const auto node = yaml["cost_cache"]; node && node["resolution"].as<double>(0) > 0) {
+        cost_cache = std::make_unique<rr::CostCache<ctrl_dim>>(node["capacity"].as<size_t>(8192),
+                                                               node["resolution"].as<double>());
+    }
+    auto memoize = [&](const rr::CostFunction<ctrl_dim>& fn) { return cost_cache ? cost_cache->Wrap(fn) : fn; };
+
+    PlanStats stats;
+    rr::CostFunctionTiming timing;
+    auto make_unmemoized_cost_fn = [&](const rr::BicycleModel& model) {
+        if (lattice_scoring && &model == &vehicle_model) {
+            return rr::MakeCostFunction(*motion_lattice, *map_cost, weights, speed_model->GetValMax(), &timing);
+        }
+        return rr::MakeCostFunction(model, *map_cost, weights, speed_model->GetValMax(), &timing);
+    };
+    auto make_cost_fn = [&](const rr::BicycleModel& model) { return memoize(make_unmemoized_cost_fn(model)); };
+    rr::CostFunction<ctrl_dim> cost_fn = make_unmemoized_cost_fn(vehicle_model);
+
+    rosbag::Bag bag(bag_path, rosbag::bagmode::Read);
+    // a bag recorded with both forms subscribed holds every map twice; plan each once, from the compact form if any
+    std::string map_topic = rr::CompactObstacleTopic(config.map_topic);
+    if (rosbag::View(bag, rosbag::TopicQuery(map_topic)).size() == 0) {
+        map_topic = config.map_topic;
+    }
+    const std::vector<std::string> topics = { map_topic, config.speed_topic, config.steering_topic, "/tf",
+                                              "/tf_static" };
+    rosbag::View view(bag, rosbag::TopicQuery(topics));
+
+    tf2::BufferCore tf_buffer(view.getEndTime() - view.getBeginTime() + ros::Duration(1.0));
+    double speed = 0;
+    double angle = 0;
+    bool started = false;
+
+    for (const rosbag::MessageInstance& m : view) {
+        const double t = m.getTime().toSec();
+
+        if (m.getTopic() == "/tf" || m.getTopic() == "/tf_static") {
+            if (auto tf_msg = m.instantiate<tf2_msgs::TFMessage>()) {
+                for (const auto& transform : tf_msg->transforms) {
+                    tf_buffer.setTransform(transform, "bag", m.getTopic() == "/tf_static");
+                }
+            }
+            continue;
+        }
+
+        if (m.getTopic() == config.speed_topic) {
+            if (auto msg = m.instantiate<rr_msgs::speed>(); msg && config.speed_type == "speed") {
+                speed = msg->speed;
+            } else if (auto msg = m.instantiate<rr_msgs::chassis_state>(); msg && config.speed_type == "chassis") {
+                speed = msg->speed_mps;
+            } else if (auto msg = m.instantiate<nav_msgs::Odometry>(); msg && config.speed_type == "odometry") {
+                speed = msg->twist.twist.linear.x;
+            }
+        }
+        if (m.getTopic() == config.steering_topic) {
+            if (auto msg = m.instantiate<rr_msgs::steering>(); msg && config.steering_type == "steering") {
+                angle = msg->angle;
+            } else if (auto msg = m.instantiate<rr_msgs::chassis_state>(); msg && config.steering_type == "chassis") {
+                angle = msg->steer_rad;
+            }
+        }
+        if (m.getTopic() != map_topic) {
+            continue;
+        }
+
+        if (!started) {
+            steer_model->Reset(angle, t);
+            speed_model->Reset(speed, t);
+            started = true;
+        }
+        steer_model->Update(angle, t);
+        speed_model->Update(speed, t);
+
+        double map_stamp;
+        rr::ObstaclePoints points;
+        if (auto compact_msg = m.instantiate<rr_msgs::obstacle_points>()) {
+            points = rr::ObstaclePoints(compact_msg);
+        } else if (auto cloud_msg = m.instantiate<sensor_msgs::PointCloud2>()) {
+            points = rr::ObstaclePoints(cloud_msg);
+        }
+
+        if (points.valid()) {
+            map_stamp = points.header().stamp.toSec();
+            // the same single pass from the message buffer as NearestPointCacheRos
+            pcl::PointCloud<rr::NearestPointCache::point_t> cloud;
+            cloud.reserve(points.size());
+            points.ForEach([&cloud](float x, float y) { cloud.push_back(rr::NearestPointCache::point_t(x, y, 0)); });
+            static_cast<rr::NearestPointCache&>(*map_cost).SetMap(std::move(cloud));
+        } else if (auto grid_msg = m.instantiate<nav_msgs::OccupancyGrid>()) {
+            map_stamp = grid_msg->header.stamp.toSec();
+            rr::Pose robot_pose;
+            try {
+                auto transform = tf_buffer.lookupTransform(grid_msg->header.frame_id, config.robot_base_frame,
+                                                           ros::Time(0));
+                tf::Transform tf_transform;
+                tf::transformMsgToTF(transform.transform, tf_transform);
+                robot_pose = rr::FromTransform(tf_transform);
+            } catch (tf2::TransformException& ex) {
+                stats.skipped_maps++;
+                continue;
+            }
+
+            auto grid = rr::FromOccupancyGridMsg(*grid_msg);
+            if (config.map_type == "distance_map") {
+                static_cast<rr::DistanceMap&>(*map_cost).SetMap(grid, robot_pose);
+            } else {
+                static_cast<rr::InflationMap&>(*map_cost).SetMap(grid, robot_pose);
+            }
+        } else {
+            stats.skipped_maps++;
+            continue;
+        }
+
+        const rr::PlanRecord* record = nullptr;
+        if (!recording.empty()) {
+            record = FindRecord(recording, map_stamp);
+            if (!record) {
+                continue;
+            }
+            if (record->ctrl_dim != ctrl_dim || record->n_segments != last_controls.cols()) {
+                throw std::runtime_error("flight recording does not match n_segments of this config");
+            }
+            steer_model->Reset(record->steer_value, record->filter_time);
+            steer_model->SetTarget(record->steer_target);
+            speed_model->Reset(record->speed_value, record->filter_time);
+            speed_model->SetTarget(record->speed_target);
+            for (int i = 0; i < record->n_segments * ctrl_dim; ++i) {
+                last_controls.data()[i] = record->init_controls[i];
+            }
+        }
+
+        // same steps as processMap() in planner_node, minus publishing
+        auto start = std::chrono::steady_clock::now();
+
+        if (cost_cache) {
+            cost_cache->Clear();
+        }
+
+        rr::Controls<ctrl_dim> controls;
+        if (control_spline) {
+            rr::Controls<ctrl_dim> init_knots = control_spline->Fit(last_controls, ctrl_limits);
+            rr::Controls<ctrl_dim> knots =
+                  optimizer->Optimize(memoize(control_spline->Wrap(cost_fn)), init_knots, ctrl_limits);
+            controls = control_spline->Evaluate(knots);
+        } else if (coarse_to_fine) {
+            controls = coarse_to_fine->Optimize(*optimizer, make_cost_fn, vehicle_model, last_controls, ctrl_limits);
+        } else {
+            controls = optimizer->Optimize(memoize(cost_fn), last_controls, ctrl_limits);
+        }
+        rr::TrajectoryRollout rollout;
+        vehicle_model.RollOutPath(controls, rollout);
+        std::vector<rr::real_t> map_costs = map_cost->DistanceCost(rollout.path);
+        double cost = rr::TrajectoryCost(rollout.path, map_costs, weights, speed_model->GetValMax());
+        bool has_collision = std::any_of(map_costs.begin(), map_costs.end(), [](rr::real_t x) { return x < 0; });
+        last_controls = controls;
+
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        stats.latency_ms.push_back(elapsed.count());
+        stats.cost.push_back(cost);
+        stats.collisions += has_collision;
+        map_cost->SetMapStale();
+
+        if (record) {
+            std::printf("  map %.6f: recorded %8.2f ms cost %10.2f%s, replayed %8.2f ms cost %10.2f%s\n", map_stamp,
+                        record->total_ms, record->cost, record->has_collision ? " (collision)" : "", elapsed.count(),
+                        cost, has_collision ? " (collision)" : "");
+            if (record->reversing) {
+                // only the forward plan is replayed; say so when the vehicle executed the reverse one
+                std::printf("  map %.6f: executed reverse plan, cost %10.2f%s\n", map_stamp, record->reverse_cost,
+                            record->reverse_has_collision ? " (collision)" : "");
+            }
+        }
+    }
+
+    stats.evaluations = timing.evaluations;
+    return stats;
+}
+
+int main(int argc, char** argv) {
+    std::vector<rr::PlanRecord> recording;
+    int first_arg = 1;
+    if (argc > 2 && std::string(argv[1]) == "--flight-recording") {
+        try {
+            recording = rr::FlightRecorder::Load(argv[2]);
+        } catch (std::exception& ex) {
+            std::cerr << ex.what() << std::endl;
+            return 1;
+        }
+        first_arg = 3;
+    }
+
+    if (argc - first_arg < 2) {
+        std::cerr << "usage: planner_replay [--flight-recording <recording.bin>] <bag> <planner_config.yaml> "
+                     "[<planner_config.yaml> ...]"
+                  << std::endl;
+        return 1;
+    }
+
+    const std::string bag_path = argv[first_arg];
+
+    std::printf("%-40s %6s %8s %8s %8s %8s %10s %10s %9s %12s\n", "config", "plans", "p50 ms", "p95 ms", "p99 ms",
+                "max ms", "mean cost", "p95 cost", "collide %", "evals/sec");
+
+    for (int i = first_arg + 1; i < argc; ++i) {
+        PlanStats stats;
+        try {
+            stats = Replay(bag_path, LoadConfig(argv[i]), recording);
+        } catch (std::exception& ex) {
+            std::cerr << argv[i] << ": " << ex.what() << std::endl;
+            return 1;
+        }
+
+        const size_t n = stats.latency_ms.size();
+        if (stats.skipped_maps > 0) {
+            std::cerr << argv[i] << ": skipped " << stats.skipped_maps << " maps without a robot pose" << std::endl;
+        }
+        if (n == 0) {
+            std::printf("%-40s %6d (no map messages found)\n", argv[i], 0);
+            continue;
+        }
+
+        const double total_ms = std::accumulate(stats.latency_ms.begin(), stats.latency_ms.end(), 0.0);
+        const double mean_cost = std::accumulate(stats.cost.begin(), stats.cost.end(), 0.0) / n;
+        std::printf("%-40s %6zu %8.2f %8.2f %8.2f %8.2f %10.2f %10.2f %9.1f %12.0f\n", argv[i], n,
+                    percentile(stats.latency_ms, 50), percentile(stats.latency_ms, 95),
+                    percentile(stats.latency_ms, 99), percentile(stats.latency_ms, 100), mean_cost,
+                    percentile(stats.cost, 95), 100.0 * stats.collisions / n, stats.evaluations / (total_ms / 1000));
+    }
+
+    return 0;
+}
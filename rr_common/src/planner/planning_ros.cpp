@@ -0,0 +1,143 @@
+#include <parameter_assertions/assertions.h>
+#include <rr_common/planning/planning_ros.h>
+
+namespace rr {
+
+void LoadParams(const ros::NodeHandle& nh, Rectangle& params) {
+    assertions::getParam(nh, "min_x", params.min_x);
+    assertions::getParam(nh, "max_x", params.max_x);
+    assertions::getParam(nh, "min_y", params.min_y);
+    assertions::getParam(nh, "max_y", params.max_y);
+
+    double origin_x, origin_y, origin_theta;
+    assertions::param(nh, "origin_x", origin_x, 0.0);
+    assertions::param(nh, "origin_y", origin_y, 0.0);
+    assertions::param(nh, "origin_theta", origin_theta, 0.0);
+    params.origin = Pose(origin_x, origin_y, origin_theta);
+}
+
+void LoadParams(const ros::NodeHandle& nh, LinearTrackingFilter::Params& params) {
+    assertions::getParam(nh, "init_val", params.init_val);
+    assertions::getParam(nh, "val_max", params.val_max);
+    assertions::getParam(nh, "val_min", params.val_min, { assertions::less(params.val_max) });
+    assertions::getParam(nh, "rate_min", params.rate_min, { assertions::less<double>(0) });
+    assertions::getParam(nh, "rate_max", params.rate_max, { assertions::greater<double>(0) });
+}
+
+void LoadParams(const ros::NodeHandle& nh, BicycleModel::Params& params) {
+    assertions::getParam(nh, "segment_size", params.segment_size);
+    assertions::getParam(nh, "dt", params.dt);
+    assertions::getParam(nh, "wheel_base", params.wheel_base);
+    assertions::getParam(nh, "lateral_accel", params.lateral_accel);
+    assertions::param(nh, "lookup_table_size", params.lookup_table_size, 0, { assertions::greater_eq(0) });
+}
+
+void LoadParams(const ros::NodeHandle& nh, DistanceMap::Params& params) {
+    LoadParams(ros::NodeHandle(nh, "hitbox"), params.hitbox);
+    assertions::getParam(nh, "cost_scaling_factor", params.cost_scaling_factor, { assertions::greater_eq(0.0) });
+    assertions::getParam(nh, "wall_inflation", params.wall_inflation, { assertions::greater_eq(0.0) });
+}
+
+void LoadParams(const ros::NodeHandle& nh, InflationMap::Params& params) {
+    LoadParams(ros::NodeHandle(nh, "hitbox"), params.hitbox);
+    assertions::getParam(nh, "lethal_threshold", params.lethal_threshold,
+                         { assertions::greater(0), assertions::less(256) });
+}
+
+void LoadParams(const ros::NodeHandle& nh, NearestPointCache::Params& params) {
+    LoadParams(ros::NodeHandle(nh, "map_limits"), params.map_limits);
+    LoadParams(ros::NodeHandle(nh, "hitbox"), params.hitbox);
+    assertions::getParam(nh, "cache_resolution", params.cache_resolution, { assertions::greater(0.0) });
+    assertions::getParam(nh, "distance_decay_factor", params.distance_decay_factor, { assertions::greater(0.0) });
+}
+
+void LoadParams(const ros::NodeHandle& nh, CostWeights& params) {
+    assertions::getParam(nh, "k_map_cost", params.k_map_cost);
+    assertions::getParam(nh, "k_speed", params.k_speed);
+    assertions::getParam(nh, "k_steering", params.k_steering);
+    assertions::getParam(nh, "k_angle", params.k_angle);
+    assertions::getParam(nh, "collision_penalty", params.collision_penalty);
+}
+
+void LoadParams(const ros::NodeHandle& nh, CoarseToFinePlanner::Params& params) {
+    assertions::getParam(nh, "levels", params.levels);
+    for (size_t i = 0; i < params.levels.size(); ++i) {
+        ROS_ASSERT(params.levels[i] > 0);
+        ROS_ASSERT_MSG(i == 0 || params.levels[i] > params.levels[i - 1], "multiresolution levels must increase");
+    }
+    assertions::param(nh, "dt_factor", params.dt_factor, 2, { assertions::greater(0) });
+    assertions::getParam(nh, "refine_tries", params.refine_tries, { assertions::greater(0) });
+
+    std::vector<double> stddev;
+    assertions::getParam(nh, "refine_stddev", stddev, { assertions::size<std::vector<double>>(1) });
+    ROS_ASSERT(stddev[0] > 0);
+    params.refine_stddev(0) = stddev[0];
+}
+
+void LoadParams(const ros::NodeHandle& nh, LatticeSearchOptimizer::Params& params) {
+    assertions::getParam(nh, "deadline_ms", params.deadline_ms, { assertions::greater(0.0) });
+    assertions::getParam(nh, "xy_resolution", params.xy_resolution, { assertions::greater(0.0) });
+    assertions::getParam(nh, "theta_bins", params.theta_bins, { assertions::greater(0) });
+    assertions::getParam(nh, "num_controls", params.num_controls, { assertions::greater(1) });
+    assertions::param(nh, "epsilon_start", params.epsilon_start, 3.0, { assertions::greater_eq(1.0) });
+    assertions::param(nh, "epsilon_step", params.epsilon_step, 1.0, { assertions::greater(0.0) });
+    assertions::param(nh, "max_expansions", params.max_expansions, 100000, { assertions::greater(0) });
+    assertions::param(nh, "reuse_stride", params.reuse_stride, 0, { assertions::greater_eq(0) });
+    assertions::param(nh, "reuse_tolerance", params.reuse_tolerance, 0.05, { assertions::greater_eq(0.0) });
+}
+
+template <int ctrl_dim>
+void LoadParams(const ros::NodeHandle& nh, typename AnnealingOptimizer<ctrl_dim>::Params& params) {
+    assertions::getParam(nh, "annealing_steps", params.annealing_steps, { assertions::greater(0) });
+    assertions::getParam(nh, "acceptance_scale", params.acceptance_scale, { assertions::greater(0.0) });
+    assertions::getParam(nh, "temperature_end", params.temperature_end, { assertions::greater(0.0) });
+    assertions::param(nh, "num_chains", params.num_chains, 1, { assertions::greater(0) });
+    assertions::param(nh, "swap_interval", params.swap_interval, 50, { assertions::greater(0) });
+    assertions::param(nh, "batch_size", params.batch_size, 1, { assertions::greater(0) });
+    assertions::param(nh, "batch_sample", params.batch_sample, false);
+
+    std::vector<double> stddev_start;
+    assertions::getParam(nh, "stddevs_start", stddev_start, { assertions::size<std::vector<double>>(ctrl_dim) });
+
+    for (size_t i = 0; i < ctrl_dim; ++i) {
+        ROS_ASSERT(stddev_start[i] > 0);
+        params.stddev_start(i) = stddev_start[i];
+    }
+}
+
+template <int ctrl_dim>
+void LoadParams(const ros::NodeHandle& nh, typename HillClimbOptimizer<ctrl_dim>::Params& params) {
+    assertions::getParam(nh, "num_workers", params.num_workers, { assertions::greater(0) });
+    assertions::getParam(nh, "num_restarts", params.num_restarts, { assertions::greater(0) });
+    assertions::getParam(nh, "local_optimum_tries", params.local_optimum_tries, { assertions::greater(0) });
+
+    std::vector<double> stddev;
+    assertions::getParam(nh, "neighbor_stddev", stddev, { assertions::size<std::vector<double>>(ctrl_dim) });
+
+    for (size_t i = 0; i < ctrl_dim; ++i) {
+        ROS_ASSERT(stddev[i] > 0);
+        params.neighbor_stddev(i) = stddev[i];
+    }
+}
+
+template void LoadParams<1>(const ros::NodeHandle&, AnnealingOptimizer<1>::Params&);
+template void LoadParams<2>(const ros::NodeHandle&, AnnealingOptimizer<2>::Params&);
+template void LoadParams<1>(const ros::NodeHandle&, HillClimbOptimizer<1>::Params&);
+template void LoadParams<2>(const ros::NodeHandle&, HillClimbOptimizer<2>::Params&);
+
+OccupancyGrid FromOccupancyGridMsg(const nav_msgs::OccupancyGrid& msg) {
+    OccupancyGrid grid;
+    grid.data = msg.data;
+    grid.width = msg.info.width;
+    grid.height = msg.info.height;
+    grid.resolution = msg.info.resolution;
+    grid.origin_x = msg.info.origin.position.x;
+    grid.origin_y = msg.info.origin.position.y;
+    return grid;
+}
+
+Pose FromTransform(const tf::Transform& transform) {
+    return Pose(transform.getOrigin().x(), transform.getOrigin().y(), tf::getYaw(transform.getRotation()));
+}
+
+}  // namespace rr
@@ -0,0 +1,100 @@
+#include <rr_common/planning/rolling_grid.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace rr {
+
+RollingGrid::RollingGrid(const Params& params)
+      : resolution_(params.resolution)
+      , size_(params.size)
+      , origin_col_(0)
+      , origin_row_(0)
+      , hits_(static_cast<size_t>(params.size) * params.size, 0)
+      , last_seen_(static_cast<size_t>(params.size) * params.size, 0) {}
+
+void RollingGrid::Recenter(double x, double y) {
+    const auto new_col = static_cast<int64_t>(std::floor(x / resolution_)) - size_ / 2;
+    const auto new_row = static_cast<int64_t>(std::floor(y / resolution_)) - size_ / 2;
+    const int64_t shift_col = new_col - origin_col_;
+    const int64_t shift_row = new_row - origin_row_;
+
+    if (std::abs(shift_col) >= size_ || std::abs(shift_row) >= size_) {
+        Clear();
+    } else {
+        // the storage of columns and rows leaving on one side is reused for those entering on the other
+        const int64_t first_col = shift_col > 0 ? origin_col_ : new_col;
+        for (int64_t col = first_col; col < first_col + std::abs(shift_col); ++col) {
+            for (int64_t row = origin_row_; row < origin_row_ + size_; ++row) {
+                hits_[Index(col, row)] = 0;
+            }
+        }
+        const int64_t first_row = shift_row > 0 ? origin_row_ : new_row;
+        for (int64_t row = first_row; row < first_row + std::abs(shift_row); ++row) {
+            std::fill_n(hits_.begin() + Index(0, row), size_, 0);
+        }
+    }
+
+    origin_col_ = new_col;
+    origin_row_ = new_row;
+}
+
+void RollingGrid::AddHit(double x, double y, double time) {
+    const auto col = static_cast<int64_t>(std::floor(x / resolution_));
+    const auto row = static_cast<int64_t>(std::floor(y / resolution_));
+    if (col < origin_col_ || col >= origin_col_ + size_ || row < origin_row_ || row >= origin_row_ + size_) {
+        return;
+    }
+    const size_t i = Index(col, row);
+    if (hits_[i] < std::numeric_limits<uint16_t>::max()) {
+        ++hits_[i];
+    }
+    last_seen_[i] = time;
+}
+
+void RollingGrid::Clear() {
+    std::fill(hits_.begin(), hits_.end(), 0);
+}
+
+void RollingGrid::Expire(double min_time) {
+    // branchless over the whole window, so it vectorizes
+    for (size_t i = 0; i < hits_.size(); ++i) {
+        hits_[i] = last_seen_[i] < min_time ? 0 : hits_[i];
+    }
+}
+
+void RollingGrid::ClearInside(const std::vector<HalfPlane>& polygon) {
+    for (int64_t row = origin_row_; row < origin_row_ + size_; ++row) {
+        const double y = (row + 0.5) * resolution_;
+
+        // intersect the half-planes' bounds on x along this row
+        double x_min = -std::numeric_limits<double>::infinity();
+        double x_max = std::numeric_limits<double>::infinity();
+        for (const HalfPlane& h : polygon) {
+            const double bound = h.c - h.b * y;  // a * x > bound
+            if (h.a > 0) {
+                x_min = std::max(x_min, bound / h.a);
+            } else if (h.a < 0) {
+                x_max = std::min(x_max, bound / h.a);
+            } else if (bound >= 0) {
+                x_max = x_min;  // the row is outside a half-plane parallel to it
+            }
+        }
+        x_min = std::max(x_min, (origin_col_ - 1) * resolution_);
+        x_max = std::min(x_max, (origin_col_ + size_ + 1) * resolution_);
+        if (x_min >= x_max) {
+            continue;
+        }
+
+        // columns whose centers are strictly between the bounds
+        const auto first = std::max(origin_col_, static_cast<int64_t>(std::floor(x_min / resolution_ - 0.5)) + 1);
+        const auto last = std::min(origin_col_ + size_ - 1,
+                                   static_cast<int64_t>(std::ceil(x_max / resolution_ - 0.5)) - 1);
+        for (int64_t col = first; col <= last; ++col) {
+            hits_[Index(col, row)] = 0;
+        }
+    }
+}
+
+}  // namespace rr
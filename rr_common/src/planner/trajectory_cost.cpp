@@ -0,0 +1,76 @@
+#include <rr_common/planning/trajectory_cost.h>
+
+#include <chrono>
+
+namespace rr {
+
+real_t TrajectoryCost(const Path& path, const std::vector<real_t>& map_costs, const CostWeights& weights,
+                      real_t max_speed) {
+    real_t cost = 0;
+    real_t inflator = 1;
+    real_t gamma = kTrajectoryCostDiscount;
+    for (size_t i = 0; i < path.size(); ++i) {
+        cost *= gamma;
+        inflator *= gamma;
+        if (map_costs[i] >= 0) {
+            cost += weights.k_map_cost * map_costs[i];
+            cost += weights.k_speed * std::pow(max_speed - path.speed[i], 2);
+            cost += weights.k_steering * std::abs(path.steer[i]);
+            cost += weights.k_angle * std::abs(path.theta[i]);
+        } else {
+            cost += weights.collision_penalty * (path.size() - i);
+            break;
+        }
+    }
+    return cost / inflator;
+}
+
+namespace {
+
+/**
+ * Cost function over any vehicle model with a BicycleModel-style RollOutPath
+ */
+template <typename Model>
+CostFunction<1> MakeRolloutCostFunction(const Model& model, MapCostInterface& map_cost, const CostWeights& weights,
+                                        real_t max_speed, CostFunctionTiming* timing) {
+    if (timing) {
+        return [&model, &map_cost, weights, max_speed, timing](const Controls<1>& controls) -> real_t {
+            using clock = std::chrono::steady_clock;
+            auto start = clock::now();
+            TrajectoryRollout rollout;
+            model.RollOutPath(controls, rollout);
+            auto rollout_end = clock::now();
+            std::vector<real_t> map_costs = map_cost.DistanceCost(rollout.path);
+            real_t cost = TrajectoryCost(rollout.path, map_costs, weights, max_speed);
+            auto end = clock::now();
+
+            timing->evaluations.fetch_add(1, std::memory_order_relaxed);
+            timing->rollout_ns.fetch_add(std::chrono::nanoseconds(rollout_end - start).count(),
+                                         std::memory_order_relaxed);
+            timing->cost_lookup_ns.fetch_add(std::chrono::nanoseconds(end - rollout_end).count(),
+                                             std::memory_order_relaxed);
+            return cost;
+        };
+    }
+
+    return [&model, &map_cost, weights, max_speed](const Controls<1>& controls) -> real_t {
+        TrajectoryRollout rollout;
+        model.RollOutPath(controls, rollout);
+        std::vector<real_t> map_costs = map_cost.DistanceCost(rollout.path);
+        return TrajectoryCost(rollout.path, map_costs, weights, max_speed);
+    };
+}
+
+}  // namespace
+
+CostFunction<1> MakeCostFunction(const BicycleModel& model, MapCostInterface& map_cost, const CostWeights& weights,
+                                 real_t max_speed, CostFunctionTiming* timing) {
+    return MakeRolloutCostFunction(model, map_cost, weights, max_speed, timing);
+}
+
+CostFunction<1> MakeCostFunction(const MotionLattice& lattice, MapCostInterface& map_cost, const CostWeights& weights,
+                                 real_t max_speed, CostFunctionTiming* timing) {
+    return MakeRolloutCostFunction(lattice, map_cost, weights, max_speed, timing);
+}
+
+}  // namespace rr
@@ -0,0 +1,68 @@
+#include <rr_common/planning/worker_pool.h>
+
+namespace rr {
+
+WorkerPool::WorkerPool(int num_threads)
+      : task_(nullptr), task_count_(0), next_index_(0), busy_workers_(0), generation_(0), stop_(false) {
+    for (int i = 0; i < num_threads; ++i) {
+        threads_.emplace_back(&WorkerPool::WorkerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& t : threads_) {
+        t.join();
+    }
+}
+
+void WorkerPool::ParallelFor(int n, const std::function<void(int)>& fn) {
+    {
+        std::lock_guard lock(mutex_);
+        task_ = &fn;
+        task_count_ = n;
+        next_index_ = 0;
+        busy_workers_ = static_cast<int>(threads_.size());
+        generation_++;
+    }
+    work_cv_.notify_all();
+
+    RunTasks();
+
+    std::unique_lock lock(mutex_);
+    done_cv_.wait(lock, [this] { return busy_workers_ == 0; });
+    task_ = nullptr;
+}
+
+void WorkerPool::RunTasks() {
+    for (int i = next_index_++; i < task_count_; i = next_index_++) {
+        (*task_)(i);
+    }
+}
+
+void WorkerPool::WorkerLoop() {
+    unsigned long seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock lock(mutex_);
+            work_cv_.wait(lock, [&] { return stop_ || generation_ != seen_generation; });
+            if (stop_) {
+                return;
+            }
+            seen_generation = generation_;
+        }
+
+        RunTasks();
+
+        std::lock_guard lock(mutex_);
+        if (--busy_workers_ == 0) {
+            done_cv_.notify_one();
+        }
+    }
+}
+
+}  // namespace rr
@@ -1,27 +1,19 @@
 /**
- * Simple program to subscribe to several pointclouds and output their combined
- * result at a set frequency.
+ * Simple nodelet to subscribe to several pointclouds and output their combined
+ * result whenever one of them changes.
  */
 
-#include <pcl/filters/voxel_grid.h>
-#include <pcl/point_cloud.h>
-#include <pcl/point_types.h>
-#include <pcl_conversions/pcl_conversions.h>
-#include <pcl_ros/transforms.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
 #include <ros/ros.h>
-#include <sensor_msgs/PointCloud2.h>
+#include <rr_common/planning/worker_pool.h>
 #include <tf/transform_listener.h>
 
-using cloud_t = pcl::PointCloud<pcl::PointXYZ>;
-using cloud_ptr_t = pcl::PointCloud<pcl::PointXYZ>::Ptr;
+#include <algorithm>
+#include <memory>
+#include <rr_common/obstacle_transport.hpp>
 
-std::map<std::string, sensor_msgs::PointCloud2ConstPtr> cache;
-bool has_new_info;
-
-void cloudCallback(const sensor_msgs::PointCloud2ConstPtr& msg, std::string topic) {
-    cache[topic] = msg;
-    has_new_info = true;
-}
+namespace rr {
 
 /**
  * @note http://stackoverflow.com/a/27511119
@@ -36,100 +28,187 @@ std::vector<std::string> split(const std::string& s, char delim) {
     return elems;
 }
 
-int main(int argc, char** argv) {
-    ros::init(argc, argv, "pointcloud_combiner");
-
-    ros::NodeHandle nh;
-    ros::NodeHandle nh_private("~");
+/*
+ * PointCloudCombiner:
+ * - each source keeps its newest cloud already transformed into the combined frame, so a new cloud only costs its
+ *   own transform, and the merged cloud is published as soon as it's ready
+ * - transforms that only involve static frames are looked up once and kept; others are looked up at the cloud's
+ *   stamp without waiting. A cloud whose transform isn't there yet is retried shortly, until transform_timeout
+ * - sources that are ready at the same time are transformed in parallel
+ */
+class PointCloudCombiner : public nodelet::Nodelet {
+  private:
+    using point_t = PointCloudXYView::Point;
+
+    struct Source {
+        ObstaclePoints cloud;         // newest cloud
+        bool pending = false;         // cloud hasn't been transformed yet
+        tf::Transform transform;      // combined frame from the cloud's frame, once found
+        std::vector<point_t> points;  // newest transformed cloud, in the combined frame
+        ros::Time stamp;              // of points
+    };
+
+    std::map<std::string, Source> sources_;
+    std::map<std::string, tf::Transform> static_transforms_;  // by source frame
+    std::vector<point_t> combo_cloud_;
+    std::string combined_frame_;
+    ros::Duration transform_timeout_;
+
+    std::vector<std::unique_ptr<ObstacleSubscriber>> partial_subscribers_;
+    ObstaclePublisher combo_pub_;
+    std::unique_ptr<tf::TransformListener> tf_listener_;
+    std::unique_ptr<WorkerPool> worker_pool_;
+    ros::Timer retry_timer_;
+
+    void CloudCallback(const ObstaclePoints& points, Source& source) {
+        source.cloud = points;
+        source.pending = true;
+        Merge();
+    }
 
-    cloud_ptr_t combo_cloud(new cloud_t);
-    cloud_ptr_t transformed(new cloud_t);
+    void Retry(const ros::TimerEvent&) {
+        Merge();
+    }
 
-    std::string sourceList = nh_private.param("sources", std::string());
-    std::string publishName = nh_private.param("destination", std::string("/map"));
-    std::string combinedFrame = nh_private.param("combined_frame", std::string("base_footprint"));
-    int refreshRate = nh_private.param("refresh_rate", 30);
-    float vgFilterSize = nh_private.param("vg_filter_size", 0.05);
+    /**
+     * Find the transform into the combined frame without blocking
+     * @return false if it isn't available yet
+     */
+    bool LookupTransform(const std_msgs::Header& header, tf::Transform& out) {
+        if (header.frame_id == combined_frame_) {
+            out.setIdentity();
+            return true;
+        }
 
-    auto topics = split(sourceList, ' ');
+        auto cached = static_transforms_.find(header.frame_id);
+        if (cached != static_transforms_.end()) {
+            out = cached->second;
+            return true;
+        }
 
-    std::vector<ros::Subscriber> partial_Subscribers;
+        try {
+            if (!tf_listener_->canTransform(combined_frame_, header.frame_id, ros::Time(0))) {
+                return false;
+            }
+            // a latest-time lookup through only static transforms comes back with a zero stamp
+            tf::StampedTransform latest;
+            tf_listener_->lookupTransform(combined_frame_, header.frame_id, ros::Time(0), latest);
+            if (latest.stamp_.isZero()) {
+                static_transforms_[header.frame_id] = latest;
+                out = latest;
+                return true;
+            }
 
-    for (const auto& topic : topics) {
-        partial_Subscribers.push_back(
-              nh.subscribe<sensor_msgs::PointCloud2>(topic, 1, boost::bind(cloudCallback, _1, topic)));
-        ROS_INFO_STREAM("Mapper subscribed to " << topic);
+            if (!tf_listener_->canTransform(combined_frame_, header.frame_id, header.stamp)) {
+                return false;
+            }
+            tf::StampedTransform transform;
+            tf_listener_->lookupTransform(combined_frame_, header.frame_id, header.stamp, transform);
+            out = transform;
+            return true;
+        } catch (tf::TransformException& ex) {
+            NODELET_ERROR_THROTTLE(1.0, "%s", ex.what());
+            return false;
+        }
     }
 
-    auto combo_pub = nh.advertise<sensor_msgs::PointCloud2>(publishName, 1);
-
-    // set up point reduction filter
-    pcl::VoxelGrid<pcl::PointXYZ> filterVG;
-    filterVG.setLeafSize(vgFilterSize, vgFilterSize, vgFilterSize);
-
-    tf::TransformListener tfListener;
-
-    ROS_INFO("starting pointcloud_combiner main loop");
+    static void TransformSource(Source& source) {
+        // sources are ground-plane clouds, so points are taken as z = 0, and the output is made 2D
+        const tf::Matrix3x3& basis = source.transform.getBasis();
+        const tf::Vector3& origin = source.transform.getOrigin();
+        source.points.clear();
+        source.points.reserve(source.cloud.size());
+        source.cloud.ForEach([&](float x, float y) {
+            source.points.push_back({ static_cast<float>(basis[0][0] * x + basis[0][1] * y + origin.x()),
+                                      static_cast<float>(basis[1][0] * x + basis[1][1] * y + origin.y()) });
+        });
+        source.stamp = source.cloud.header().stamp;
+        source.pending = false;
+    }
 
-    ros::Rate rate(refreshRate);
-    while (ros::ok()) {
-        ros::spinOnce();
+    void Merge() {
+        const ros::Time now = ros::Time::now();
 
-        if (has_new_info) {
-            combo_cloud->clear();
+        std::vector<Source*> ready;
+        bool waiting = false;
+        for (auto& [topic, source] : sources_) {
+            if (!source.pending) {
+                continue;
+            }
+            if (LookupTransform(source.cloud.header(), source.transform)) {
+                ready.push_back(&source);
+            } else if (now - source.cloud.header().stamp > transform_timeout_) {
+                NODELET_WARN_STREAM_THROTTLE(1.0, "No transform from " << source.cloud.header().frame_id << " to "
+                                                                       << combined_frame_ << ", dropping cloud from "
+                                                                       << topic);
+                source.pending = false;
+            } else {
+                waiting = true;
+            }
+        }
 
-            for (std::pair<std::string, sensor_msgs::PointCloud2ConstPtr> entry_pair :
-                 cache) {  // copy for kind-of thread safety?
-                if (!entry_pair.second) {
-                    continue;  // null pointer for message
-                }
+        if (waiting) {
+            retry_timer_.stop();
+            retry_timer_.start();
+        }
+        if (ready.empty()) {
+            return;
+        }
 
-                const auto& cloud_msg = *(entry_pair.second);
+        worker_pool_->ParallelFor(static_cast<int>(ready.size()), [&](int i) { TransformSource(*ready[i]); });
 
-                // convert from message to pcl pointcloud
-                pcl::PCLPointCloud2 pcl_pc2;
-                pcl_conversions::toPCL(cloud_msg, pcl_pc2);
+        combo_cloud_.clear();
+        ros::Time stamp;
+        for (const auto& entry : sources_) {
+            const Source& source = entry.second;
+            combo_cloud_.insert(combo_cloud_.end(), source.points.begin(), source.points.end());
+            stamp = std::max(stamp, source.stamp);
+        }
 
-                cloud_t partialCloud;
-                pcl::fromPCLPointCloud2(pcl_pc2, partialCloud);
+        if (!combo_cloud_.empty()) {
+            std_msgs::Header header;
+            header.frame_id = combined_frame_;
+            header.stamp = stamp;  // newest included cloud
 
-                if (partialCloud.points.empty()) {
-                    continue;
-                }
+            combo_pub_.Publish(header, combo_cloud_);
+        } else {
+            NODELET_INFO("pointcloud empty");
+        }
+    }
 
-                // frame transform
-                transformed->clear();
-                tfListener.waitForTransform(cloud_msg.header.frame_id, combinedFrame, ros::Time(0), ros::Duration(5.0));
-                pcl_ros::transformPointCloud(combinedFrame, partialCloud, *transformed, tfListener);
+    void onInit() override {
+        auto nh = getNodeHandle();
+        auto nh_private = getPrivateNodeHandle();
 
-                *(combo_cloud) += *transformed;
-            }
+        std::string sourceList = nh_private.param("sources", std::string());
+        std::string publishName = nh_private.param("destination", std::string("/map"));
+        combined_frame_ = nh_private.param("combined_frame", std::string("base_footprint"));
+        transform_timeout_ = ros::Duration(nh_private.param("transform_timeout", 0.5));
+        double retry_period = nh_private.param("transform_retry_period", 0.005);
+        int threads = nh_private.param("threads", 1);
 
-            // make 2D
-            for (auto& pt : combo_cloud->points) {
-                pt.z = 0;
-            }
+        combo_pub_ = ObstaclePublisher(nh, publishName);
 
-            // convert back to message
-            if (!combo_cloud->points.empty()) {
-                pcl::PCLPointCloud2 combo_pc2;
-                pcl::toPCLPointCloud2(*combo_cloud, combo_pc2);
-                sensor_msgs::PointCloud2 msg;
-                pcl_conversions::fromPCL(combo_pc2, msg);
+        tf_listener_ = std::make_unique<tf::TransformListener>(nh);
+        worker_pool_ = std::make_unique<WorkerPool>(std::max(threads - 1, 0));
+        retry_timer_ = nh.createTimer(ros::Duration(retry_period), &PointCloudCombiner::Retry, this, true, false);
 
-                msg.header.frame_id = combinedFrame;
-                msg.header.stamp = ros::Time::now();
+        auto topics = split(sourceList, ' ');
 
-                combo_pub.publish(msg);
-            } else {
-                ROS_INFO("pointcloud empty");
+        for (const auto& topic : topics) {
+            if (topic.empty()) {
+                continue;
             }
-
-            has_new_info = false;
+            Source& source = sources_[topic];
+            auto& sub = partial_subscribers_.emplace_back(std::make_unique<ObstacleSubscriber>());
+            sub->Subscribe(nh, topic, [this, &source](const ObstaclePoints& points) { CloudCallback(points, source); });
+            NODELET_INFO_STREAM("Mapper subscribed to " << topic);
         }
 
-        rate.sleep();
+        NODELET_INFO("started pointcloud_combiner");
     }
+};
 
-    return 0;
-}
+}  // namespace rr
+
+PLUGINLIB_EXPORT_CLASS(rr::PointCloudCombiner, nodelet::Nodelet);
@@ -1,92 +1,108 @@
 #include <rr_common/RelativePoseHistoryClient.h>
 
+#include <algorithm>
 #include <rr_common/angle_utils.hpp>
+#include <stdexcept>
 
 namespace rr {
 
-/**
- * Interpolate in time domain between two poses
- * @param p1 pose with smaller timestamp
- * @param p2 pose with larger timestamp
- * @param t target time
- * @return pose at time t
- */
-RelativePoseHistoryClient::Pose linear_interp(const geometry_msgs::PoseStamped& p1,
-                                              const geometry_msgs::PoseStamped& p2, const ros::Time& t) {
-    RelativePoseHistoryClient::Pose out_pose;
+void RelativePoseHistoryClient::Attach(ros::NodeHandle& nh, const std::string& segment_name) {
+    nh_ = nh;
+    try {
+        history_ = std::make_unique<SharedPoseHistory>(segment_name);
+    } catch (const std::runtime_error& e) {
+        ROS_WARN("[RelativePoseHistoryClient] %s; using /pose_history instead", e.what());
+        history_.reset();
+    }
+}
 
-    // lambda = similarity to p2
-    double dt1 = (t - p1.header.stamp).toSec();
-    double dt2 = (p2.header.stamp - p1.header.stamp).toSec();
-    double lambda = dt1 / dt2;
+bool RelativePoseHistoryClient::UseFallbackIfEmpty() {
+    PoseRecord newest{};
+    if (history_ && history_->GetNewest(newest)) {
+        fallback_sub_.shutdown();
+        fallback_history_.clear();
+        return true;
+    }
 
-    out_pose.x = p2.pose.position.x * lambda + p1.pose.position.x * (1 - lambda);
-    out_pose.y = p2.pose.position.y * lambda + p1.pose.position.y * (1 - lambda);
+    if (!fallback_sub_) {
+        ROS_WARN("[RelativePoseHistoryClient] no pose history in shared memory, subscribing to /pose_history. "
+                 "pose_tracker_server shares the full history only with processes on its own host");
+        fallback_sub_ = nh_.subscribe("/pose_history", 1, &RelativePoseHistoryClient::FallbackCallback, this);
+    }
+    return !fallback_history_.empty();
+}
 
-    double theta1 = rr::poseToYaw(p1.pose);
-    double theta2 = rr::poseToYaw(p2.pose);
-    out_pose.theta = rr::fix_angle(theta1 + lambda * rr::heading_diff(theta1, theta2));
+void RelativePoseHistoryClient::FallbackCallback(const nav_msgs::PathConstPtr& path_msg) {
+    // newest first, relative to the newest pose
+    fallback_history_.clear();
+    for (auto it = path_msg->poses.rbegin(); it != path_msg->poses.rend(); ++it) {
+        fallback_history_.push_back(
+            { it->header.stamp.toSec(), it->pose.position.x, it->pose.position.y, rr::poseToYaw(it->pose) });
+    }
+}
 
-    return out_pose;
+bool RelativePoseHistoryClient::GetNewest(PoseRecord& out) const {
+    if (fallback_history_.empty()) {
+        return history_ && history_->GetNewest(out);
+    }
+    out = fallback_history_.back();
+    return true;
 }
 
-void RelativePoseHistoryClient::callback(const nav_msgs::PathConstPtr& path_msg) {
-    history_ = path_msg;
+bool RelativePoseHistoryClient::Interpolate(double time, PoseRecord& out) const {
+    if (fallback_history_.empty()) {
+        return history_ && history_->Interpolate(time, out);
+    }
+
+    // same as the shared history: times outside it get its oldest or newest pose
+    auto next = std::upper_bound(fallback_history_.begin(), fallback_history_.end(), time,
+                                 [](double t, const PoseRecord& record) { return t < record.time; });
+    if (next == fallback_history_.begin()) {
+        out = fallback_history_.front();
+    } else if (next == fallback_history_.end()) {
+        out = fallback_history_.back();
+    } else {
+        out = InterpolatePose(*(next - 1), *next, time);
+    }
+    return true;
 }
 
-ros::Subscriber RelativePoseHistoryClient::RegisterCallback(ros::NodeHandle& nh) {
-    return nh.subscribe("/pose_history", 1, &RelativePoseHistoryClient::callback, this);
+/**
+ * @return pose b in the frame of pose a, as a Pose2D with theta in [0, 2*pi)
+ */
+RelativePoseHistoryClient::Pose relative_pose(const PoseRecord& a, const PoseRecord& b) {
+    const PoseRecord relative = RelativePose(a, b);
+    RelativePoseHistoryClient::Pose out_pose;
+    out_pose.x = relative.x;
+    out_pose.y = relative.y;
+    out_pose.theta = rr::fix_angle(relative.yaw);
+    return out_pose;
 }
 
 RelativePoseHistoryClient::Pose RelativePoseHistoryClient::GetRelativePoseAtTime(const ros::Time& t) {
-    Pose out_pose;
-    auto now = ros::Time::now();
+    PoseRecord now{};
+    PoseRecord then{};
 
-    if (!history_ || history_->poses.empty()) {
-        // case 1: no pose history. Return the current position
-        out_pose.x = out_pose.y = out_pose.theta = 0;
+    // the history holds odometry poses; times outside it get its oldest or newest pose
+    if (!UseFallbackIfEmpty() || !GetNewest(now) || !Interpolate(t.toSec(), then)) {
+        // no pose history. Return the current position
         ROS_WARN("[RelativePoseHistoryClient] Requesting relative pose but no pose "
                  "history available");
+        return Pose();
     }
+    return relative_pose(now, then);
+}
 
-    else {
-        // case 2: we have pose history
-        auto& poses = history_->poses;
-
-        // find the index of the last pose before the requested time
-        size_t i = 0;
-        while (poses[i].header.stamp > t && i < poses.size()) {
-            i++;
-        }
-
-        if (i == 0) {
-            // case 2.1: requested time is newer than any in history
-            if (t >= now) {
-                // too new; use current pose
-                out_pose.x = out_pose.y = out_pose.theta = 0;
-            } else {
-                // interpolate between newest point in history and now
-                geometry_msgs::PoseStamped now_pose;  // x = y = z = r = p = y = 0
-                now_pose.header.stamp = now;
-                now_pose.pose.orientation = tf::createQuaternionMsgFromYaw(0);
-                out_pose = linear_interp(poses[0], now_pose, t);
-            }
-        }
-
-        else if (i >= poses.size()) {
-            // case 2.2: requested time is older than any in history
-            out_pose.x = poses.back().pose.position.x;
-            out_pose.y = poses.back().pose.position.y;
-            out_pose.theta = rr::poseToYaw(poses.back().pose);
-        }
+RelativePoseHistoryClient::Pose RelativePoseHistoryClient::GetRelativePose(const ros::Time& from, const ros::Time& to) {
+    PoseRecord from_pose{};
+    PoseRecord to_pose{};
 
-        else {
-            // case 2.3: requested time is between two existing points
-            out_pose = linear_interp(poses[i], poses[i - 1], t);
-        }
+    if (!UseFallbackIfEmpty() || !Interpolate(from.toSec(), from_pose) || !Interpolate(to.toSec(), to_pose)) {
+        ROS_WARN("[RelativePoseHistoryClient] Requesting relative pose but no pose "
+                 "history available");
+        return Pose();
     }
-
-    return out_pose;
+    return relative_pose(from_pose, to_pose);
 }
 
 }  // namespace rr
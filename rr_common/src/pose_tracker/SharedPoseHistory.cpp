@@ -0,0 +1,152 @@
+#include <fcntl.h>
+#include <rr_common/SharedPoseHistory.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace rr {
+
+// all zeros is a valid empty history, so whichever process creates the segment needn't initialize it
+struct SharedPoseHistory::Segment {
+    std::atomic<uint32_t> sequence;  // odd while a write is in progress
+    uint32_t count;                  // records held, up to kCapacity
+    uint64_t head;                   // index one past the newest record, before wrapping
+    PoseRecord records[kCapacity];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared sequence counter must be lock-free");
+
+SharedPoseHistory::SharedPoseHistory(const std::string& name, bool writer) : segment_(nullptr) {
+    const int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd < 0) {
+        throw std::runtime_error("could not open shared pose history " + name + ": " + std::strerror(errno));
+    }
+    // growing zero-fills; an existing segment already has this size
+    if (ftruncate(fd, sizeof(Segment)) != 0) {
+        close(fd);
+        throw std::runtime_error("could not size shared pose history " + name + ": " + std::strerror(errno));
+    }
+    void* mapping = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("could not map shared pose history " + name + ": " + std::strerror(errno));
+    }
+    segment_ = static_cast<Segment*>(mapping);
+
+    if (writer) {
+        // a writer killed mid-write leaves the sequence odd; readers would take every later write as finished
+        segment_->sequence.store(0, std::memory_order_release);
+    }
+}
+
+SharedPoseHistory::~SharedPoseHistory() {
+    munmap(segment_, sizeof(Segment));
+}
+
+// parity is forced rather than toggled, so a bad sequence left in the segment can't flip its meaning
+void SharedPoseHistory::BeginWrite() {
+    const uint32_t sequence = segment_->sequence.load(std::memory_order_relaxed);
+    segment_->sequence.store(sequence | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void SharedPoseHistory::EndWrite() {
+    const uint32_t sequence = segment_->sequence.load(std::memory_order_relaxed);
+    segment_->sequence.store((sequence | 1) + 1, std::memory_order_release);
+}
+
+void SharedPoseHistory::Assign(const PoseRecord* records, size_t count) {
+    if (count > kCapacity) {
+        records += count - kCapacity;
+        count = kCapacity;
+    }
+    BeginWrite();
+    std::memcpy(segment_->records, records, count * sizeof(PoseRecord));
+    segment_->count = static_cast<uint32_t>(count);
+    segment_->head = count;
+    EndWrite();
+}
+
+void SharedPoseHistory::Append(const PoseRecord& record) {
+    BeginWrite();
+    segment_->records[segment_->head % kCapacity] = record;
+    segment_->head++;
+    if (segment_->count < kCapacity) {
+        segment_->count++;
+    }
+    EndWrite();
+}
+
+bool SharedPoseHistory::Interpolate(double time, PoseRecord& out) const {
+    for (int attempt = 0; attempt < kMaxReadAttempts; ++attempt) {
+        const uint32_t sequence = segment_->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // a torn read can see any count; clamping keeps the search in bounds until the retry
+        const size_t count = std::min<size_t>(segment_->count, kCapacity);
+        const uint64_t first = segment_->head - count;
+        auto record = [&](size_t i) { return segment_->records[(first + i) % kCapacity]; };
+
+        PoseRecord result{};
+        if (count > 0) {
+            // first record newer than the requested time
+            size_t lo = 0;
+            size_t hi = count;
+            while (lo < hi) {
+                const size_t mid = (lo + hi) / 2;
+                if (record(mid).time > time) {
+                    hi = mid;
+                } else {
+                    lo = mid + 1;
+                }
+            }
+
+            if (lo == 0) {
+                result = record(0);
+            } else if (lo == count) {
+                result = record(count - 1);
+            } else {
+                result = InterpolatePose(record(lo - 1), record(lo), time);
+            }
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (segment_->sequence.load(std::memory_order_relaxed) == sequence) {
+            out = result;
+            return count > 0;
+        }
+    }
+    return false;
+}
+
+bool SharedPoseHistory::GetNewest(PoseRecord& out) const {
+    for (int attempt = 0; attempt < kMaxReadAttempts; ++attempt) {
+        const uint32_t sequence = segment_->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const bool empty = segment_->count == 0;
+        const PoseRecord newest = segment_->records[(segment_->head + kCapacity - 1) % kCapacity];
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (segment_->sequence.load(std::memory_order_relaxed) == sequence) {
+            out = newest;
+            return !empty;
+        }
+    }
+    return false;
+}
+
+}  // namespace rr
@@ -1,11 +1,13 @@
 #include <nav_msgs/Path.h>
 #include <ros/ros.h>
+#include <rr_common/SharedPoseHistory.h>
 #include <rr_msgs/axes.h>
 #include <rr_msgs/chassis_state.h>
 #include <tf/transform_datatypes.h>
 
 #include <deque>
 #include <rr_common/angle_utils.hpp>
+#include <rr_common/spsc_queue.hpp>
 
 // Types
 using ChassisState = rr_msgs::chassis_state;
@@ -18,51 +20,53 @@ struct HistoryPoint {
     double yaw;
 };
 
+struct OdometrySample {
+    enum Source { kSpeed, kYaw };
+
+    Source source;
+    ros::Time time;
+    double value;
+};
+
 // globals
-double speed_;
-double yaw_;
-ros::Time most_recent_data_time;
+rr::SPSCQueue<OdometrySample> samples(1024);  // pushed by the spinner thread, popped by the integrator
 
 void chassis_state_callback(const ChassisState::ConstPtr& msg) {
-    speed_ = msg->speed_mps;
-    most_recent_data_time = msg->header.stamp;
+    if (!samples.TryPush({ OdometrySample::kSpeed, msg->header.stamp, msg->speed_mps })) {
+        ROS_WARN_THROTTLE(1.0, "[pose_tracker] sample queue full, dropping chassis state");
+    }
 }
 
 void orientation_callback(const Orientation::ConstPtr& msg) {
-    yaw_ = msg->yaw;
-    most_recent_data_time = msg->header.stamp;
+    if (!samples.TryPush({ OdometrySample::kYaw, msg->header.stamp, msg->yaw })) {
+        ROS_WARN_THROTTLE(1.0, "[pose_tracker] sample queue full, dropping orientation");
+    }
 }
 
 /**
- * Work from the current time and calculate where we must have been previously
- * @param next_pose Pose at the end of this time slice
+ * Integrate the odometry pose over one time slice
+ * @param pose Pose at the beginning of this time slice
  * @param h1 HistoryPoint (time, speed, yaw) at beginning of time slice
  * @param h2 HistoryPoint at end of time slice
- * @return Pose at the beginning of this time slice
+ * @return Pose at the end of this time slice
  */
-geometry_msgs::PoseStamped step_reverse(const geometry_msgs::PoseStamped& next_pose, const HistoryPoint& h1,
-                                        const HistoryPoint& h2) {
+rr::PoseRecord step_forward(const rr::PoseRecord& pose, const HistoryPoint& h1, const HistoryPoint& h2) {
     // set travel heading as average between start and end of time slice
-    // note that this is relative to current heading
-    double travel_heading_end = rr::poseToYaw(next_pose.pose);
     double heading_change = rr::heading_diff(h1.yaw, h2.yaw);
-    double travel_heading_avg = rr::fix_angle(travel_heading_end - (heading_change / 2));
-    double travel_heading_start = rr::fix_angle(travel_heading_end - heading_change);
+    double travel_heading_avg = pose.yaw + heading_change / 2;
 
     // same averaging for speed
     double travel_speed = (h2.speed + h1.speed) / 2;
     double dist_traveled = travel_speed * (h2.time - h1.time).toSec();
 
-    // pose at beginning of this time slice
-    geometry_msgs::PoseStamped pose_stamped;
-    pose_stamped.header.stamp = h1.time;
+    // pose at end of this time slice
+    rr::PoseRecord next_pose{};
+    next_pose.time = h2.time.toSec();
+    next_pose.x = pose.x + dist_traveled * std::cos(travel_heading_avg);
+    next_pose.y = pose.y + dist_traveled * std::sin(travel_heading_avg);
+    next_pose.yaw = rr::fix_angle(pose.yaw + heading_change);
 
-    pose_stamped.pose.position = next_pose.pose.position;
-    pose_stamped.pose.position.x -= dist_traveled * std::cos(travel_heading_avg);
-    pose_stamped.pose.position.y -= dist_traveled * std::sin(travel_heading_avg);
-    pose_stamped.pose.orientation = tf::createQuaternionMsgFromYaw(travel_heading_start);
-
-    return pose_stamped;
+    return next_pose;
 }
 
 int main(int argc, char** argv) {
@@ -90,73 +94,96 @@ int main(int argc, char** argv) {
     int publish_resolution;
     all_defined &= nh_private.getParam("publish_resolution", publish_resolution);
 
+    std::string shared_memory_name;
+    nh_private.param<std::string>("shared_memory_name", shared_memory_name, rr::SharedPoseHistory::kDefaultName);
+
     if (!all_defined) {
         ROS_WARN("[pose_tracker] not all roslaunch params defined");
     }
 
     // subscribers
-    auto sub1 = nh.subscribe(chassis_state_topic, 1, chassis_state_callback);
-    auto sub2 = nh.subscribe(angles_topic, 1, orientation_callback);
+    auto sub1 = nh.subscribe(chassis_state_topic, 10, chassis_state_callback);
+    auto sub2 = nh.subscribe(angles_topic, 10, orientation_callback);
 
+    // clients on this host read the history from shared memory; the topic is for visualization and other hosts
+    rr::SharedPoseHistory shared_history(shared_memory_name, true);
     auto history_publisher = nh.advertise<PoseHistoryMsg>("/pose_history", 10);
 
-    // main data structure. New data goes in the front
-    std::deque<HistoryPoint> history;
+    // odometry frame, fixed where the tracker started. Every sample integrates one time slice onto the newest pose, and
+    // clients get relative poses as newest^-1 * then, so no update depends on the length of the history
+    HistoryPoint state{};  // newest speed and yaw, and the time of the newest sample
+    bool have_speed = false;
+    bool have_yaw = false;
+    rr::PoseRecord odom_pose{};
+    std::deque<rr::PoseRecord> path;  // odometry poses within time_horizon, only for visualization
 
-    speed_ = 0;
-    yaw_ = 0;
+    // callbacks run on their own thread, one only, so that they are the sample queue's single producer
+    ros::AsyncSpinner spinner(1);
+    spinner.start();
 
     ros::Rate rate(update_hz);
+    OdometrySample sample{};
     while (ros::ok()) {
         rate.sleep();
-        ros::spinOnce();
 
-        // remove any history which is too old
-        while (!history.empty() && history.back().time + time_horizon < most_recent_data_time) {
-            history.pop_back();
-        }
+        bool updated = false;
+        while (samples.TryPop(sample)) {
+            // handle time looping from rosbag, etc.
+            if (sample.time + time_horizon < state.time) {
+                have_speed = have_yaw = false;
+            }
 
-        // handle time looping from rosbag, etc.
-        if (!history.empty() && history.front().time < history.back().time) {
-            history.clear();
+            const bool was_started = have_speed && have_yaw;
+            HistoryPoint next_state = state;
+            if (sample.source == OdometrySample::kSpeed) {
+                next_state.speed = sample.value;
+                have_speed = true;
+            } else {
+                next_state.yaw = sample.value;
+                have_yaw = true;
+            }
+
+            if (!was_started) {
+                // start over once both sources have reported
+                next_state.time = sample.time;
+                odom_pose = { sample.time.toSec(), 0, 0, 0 };
+                if (have_speed && have_yaw) {
+                    shared_history.Assign(&odom_pose, 1);
+                    path.assign(1, odom_pose);
+                    updated = true;
+                }
+            } else if (sample.time > state.time) {
+                // the other source's value holds until this sample, then this one's changes linearly to its new value
+                next_state.time = sample.time;
+                odom_pose = step_forward(odom_pose, state, next_state);
+                shared_history.Append(odom_pose);
+                path.push_back(odom_pose);
+                updated = true;
+            }
+            // a sample older than the other source's newest only changes the value held from here on
+            state = next_state;
+        }
+        if (!updated) {
+            continue;
         }
 
-        // record current state
-        auto& history_front = history.emplace_front();
-        history_front.time = most_recent_data_time;
-        history_front.speed = speed_;
-        history_front.yaw = yaw_;
+        while (path.front().time + time_horizon.toSec() < odom_pose.time) {
+            path.pop_front();
+        }
 
-        // estimate previous path
-        if (history.size() >= 2) {
+        if (path.size() >= 2 && history_publisher.getNumSubscribers() > 0) {
             PoseHistoryMsg pose_history_msg;
-            pose_history_msg.header.stamp = most_recent_data_time;
+            pose_history_msg.header.stamp = state.time;
             pose_history_msg.header.frame_id = "base_footprint";
 
-            auto& origin = pose_history_msg.poses.emplace_back();  // default constructor puts this at the origin
-            origin.pose.orientation = tf::createQuaternionMsgFromYaw(0);
-            origin.header.stamp = history.front().time;
-
-            // the notation here is slightly confusing but we are moving from "next"
-            // to "current"
-            int counter = 1;
-            auto hist_it_next = history.begin();
-            auto hist_it_current = history.begin() + 1;
-            geometry_msgs::PoseStamped pose_next = pose_history_msg.poses.front();
-
-            while (hist_it_current != history.end()) {
-                // step path backwards in time
-                auto pose_current = step_reverse(pose_next, *hist_it_current, *hist_it_next);
-
-                // record in output
-                if (counter % publish_resolution == 0) {
-                    pose_history_msg.poses.push_back(pose_current);
-                }
-
-                pose_next = pose_current;
-                hist_it_current++;
-                hist_it_next++;
-                counter++;
+            // relative to the current pose, newest first, keeping every publish_resolution'th pose
+            for (size_t i = 0; i < path.size(); i += publish_resolution) {
+                const rr::PoseRecord pose = rr::RelativePose(odom_pose, path[path.size() - 1 - i]);
+                auto& pose_stamped = pose_history_msg.poses.emplace_back();
+                pose_stamped.header.stamp = ros::Time(pose.time);
+                pose_stamped.pose.position.x = pose.x;
+                pose_stamped.pose.position.y = pose.y;
+                pose_stamped.pose.orientation = tf::createQuaternionMsgFromYaw(pose.yaw);
             }
 
             history_publisher.publish(pose_history_msg);
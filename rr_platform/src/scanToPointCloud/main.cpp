@@ -3,10 +3,13 @@
 //
 
 #include <laser_geometry/laser_geometry.h>
-#include <pcl_conversions/pcl_conversions.h>
 #include <ros/ros.h>
 #include <sensor_msgs/LaserScan.h>
 #include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/point_cloud2_iterator.h>
+
+#include <cmath>
+#include <cstring>
 
 ros::Publisher pc_pub;
 double filtering_distance;
@@ -17,23 +20,24 @@ void scanCallback(const sensor_msgs::LaserScanConstPtr& msg) {
     sensor_msgs::PointCloud2 cloud;
     projector.projectLaser(*msg, cloud);
 
-    pcl::PCLPointCloud2 cloud_pc2;
-    pcl_conversions::toPCL(cloud, cloud_pc2);
-    pcl::PointCloud<pcl::PointXYZ>::Ptr cloud_pc(new pcl::PointCloud<pcl::PointXYZ>);
-    pcl::fromPCLPointCloud2(cloud_pc2, *cloud_pc);
-
-    for (auto iter = cloud_pc->begin(); iter != cloud_pc->end();) {
-        auto point = *iter;
-        auto distance = std::sqrt((point.x * point.x) + (point.y * point.y));
-        if (distance < filtering_distance) {
-            iter = cloud_pc->erase(iter);
-        } else {
-            iter++;
+    // drop close points by compacting the message's buffer in place, keeping every field the projector wrote
+    size_t kept = 0;
+    sensor_msgs::PointCloud2ConstIterator<float> iter_x(cloud, "x");
+    sensor_msgs::PointCloud2ConstIterator<float> iter_y(cloud, "y");
+    for (size_t i = 0; i < size_t(cloud.width) * cloud.height; i++, ++iter_x, ++iter_y) {
+        auto distance = std::sqrt((*iter_x * *iter_x) + (*iter_y * *iter_y));
+        if (distance >= filtering_distance) {
+            if (kept != i) {
+                std::memcpy(&cloud.data[kept * cloud.point_step], &cloud.data[i * cloud.point_step], cloud.point_step);
+            }
+            kept++;
         }
     }
 
-    pcl::toPCLPointCloud2(*cloud_pc, cloud_pc2);
-    pcl_conversions::fromPCL(cloud_pc2, cloud);
+    cloud.height = 1;
+    cloud.width = kept;
+    cloud.row_step = kept * cloud.point_step;
+    cloud.data.resize(cloud.row_step);
 
     pc_pub.publish(cloud);
 }